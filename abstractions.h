@@ -1,3 +1,6 @@
+#ifndef FUSE_BINDINGS_ABSTRACTIONS_H
+#define FUSE_BINDINGS_ABSTRACTIONS_H
+
 #include <nan.h>
 
 #define FUSE_USE_VERSION 29
@@ -29,8 +32,22 @@ NAN_INLINE static void semaphore_signal (dispatch_semaphore_t *sem) {
   dispatch_semaphore_signal(*sem);
 }
 
+NAN_INLINE static void semaphore_destroy (dispatch_semaphore_t *sem) {
+  dispatch_release(*sem);
+}
+
+typedef pthread_mutex_t abstr_mutex_t;
+
 extern pthread_mutex_t mutex;
 
+NAN_INLINE static void mutex_init (pthread_mutex_t *mutex) {
+    pthread_mutex_init(mutex, NULL);
+}
+
+NAN_INLINE static void mutex_destroy (pthread_mutex_t *mutex) {
+    pthread_mutex_destroy(mutex);
+}
+
 NAN_INLINE static void mutex_lock (pthread_mutex_t *mutex) {
     pthread_mutex_lock(mutex);
 }
@@ -63,8 +80,22 @@ NAN_INLINE static void semaphore_signal (HANDLE *sem) {
   ReleaseSemaphore(*sem, 1, NULL);
 }
 
+NAN_INLINE static void semaphore_destroy (HANDLE *sem) {
+  CloseHandle(*sem);
+}
+
+typedef HANDLE abstr_mutex_t;
+
 extern HANDLE mutex;
 
+NAN_INLINE static void mutex_init (HANDLE *mutex) {
+    *mutex = CreateMutex(NULL, false, NULL);
+}
+
+NAN_INLINE static void mutex_destroy (HANDLE *mutex) {
+    CloseHandle(*mutex);
+}
+
 NAN_INLINE static void mutex_lock (HANDLE *mutex) {
     WaitForSingleObject(*mutex, INFINITE);
 }
@@ -103,8 +134,22 @@ NAN_INLINE static void semaphore_signal (sem_t *sem) {
   sem_post(sem);
 }
 
+NAN_INLINE static void semaphore_destroy (sem_t *sem) {
+  sem_destroy(sem);
+}
+
+typedef pthread_mutex_t abstr_mutex_t;
+
 extern pthread_mutex_t mutex;
 
+NAN_INLINE static void mutex_init (pthread_mutex_t *mutex) {
+    pthread_mutex_init(mutex, NULL);
+}
+
+NAN_INLINE static void mutex_destroy (pthread_mutex_t *mutex) {
+    pthread_mutex_destroy(mutex);
+}
+
 NAN_INLINE static void mutex_lock (pthread_mutex_t *mutex) {
     pthread_mutex_lock(mutex);
 }
@@ -118,9 +163,93 @@ typedef void* thread_fn_rtn_t;
 
 #endif
 
+#ifdef _WIN32
+
+NAN_INLINE static uint32_t atomic_get (volatile uint32_t *ptr) {
+  uint32_t val = *ptr;
+  MemoryBarrier();
+  return val;
+}
+
+NAN_INLINE static void atomic_set (volatile uint32_t *ptr, uint32_t val) {
+  MemoryBarrier();
+  *ptr = val;
+}
+
+NAN_INLINE static int atomic_cas (volatile uint32_t *ptr, uint32_t old, uint32_t val) {
+  return InterlockedCompareExchange((volatile LONG *) ptr, (LONG) val, (LONG) old) == (LONG) old;
+}
+
+NAN_INLINE static int atomic_cas_ptr (void * volatile *ptr, void *old, void *val) {
+  return InterlockedCompareExchangePointer(ptr, val, old) == old;
+}
+
+NAN_INLINE static uint32_t atomic_add (volatile uint32_t *ptr, int32_t val) {
+  return (uint32_t) InterlockedExchangeAdd((volatile LONG *) ptr, (LONG) val) + val;
+}
+
+NAN_INLINE static uint64_t atomic_add64 (volatile uint64_t *ptr, int64_t val) {
+  return (uint64_t) InterlockedExchangeAdd64((volatile LONG64 *) ptr, (LONG64) val) + val;
+}
+
+NAN_INLINE static void thread_yield () {
+  SwitchToThread();
+}
+
+NAN_INLINE static void thread_sleep (uint32_t ms) {
+  Sleep(ms);
+}
+
+#else
+
+#include <sched.h>
+#include <unistd.h>
+
+NAN_INLINE static uint32_t atomic_get (volatile uint32_t *ptr) {
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+NAN_INLINE static void atomic_set (volatile uint32_t *ptr, uint32_t val) {
+  __atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+}
+
+NAN_INLINE static int atomic_cas (volatile uint32_t *ptr, uint32_t old, uint32_t val) {
+  return __sync_bool_compare_and_swap(ptr, old, val);
+}
+
+NAN_INLINE static int atomic_cas_ptr (void * volatile *ptr, void *old, void *val) {
+  return __sync_bool_compare_and_swap(ptr, old, val);
+}
+
+NAN_INLINE static uint32_t atomic_add (volatile uint32_t *ptr, int32_t val) {
+  return __sync_add_and_fetch(ptr, val);
+}
+
+NAN_INLINE static uint64_t atomic_add64 (volatile uint64_t *ptr, int64_t val) {
+  return __sync_add_and_fetch(ptr, val);
+}
+
+NAN_INLINE static void thread_yield () {
+  sched_yield();
+}
+
+NAN_INLINE static void thread_sleep (uint32_t ms) {
+  usleep(ms * 1000);
+}
+
+#endif
+
+#ifdef _WIN32
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 typedef thread_fn_rtn_t(*thread_fn)(void*);
 
 void thread_create (abstr_thread_t*, thread_fn, void*);
 void thread_join (abstr_thread_t);
 
 int fusermount (char*);
+
+#endif
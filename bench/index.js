@@ -0,0 +1,256 @@
+// mounts an in memory filesystem and measures per operation latency and throughput
+// usage: node bench [--duration=3000] [--concurrency=16] [--filter=name] [--multithreaded] [--kernel-cache]
+
+var argv = parseArgs(process.argv.slice(2))
+var concurrency = Number(argv.concurrency || 16)
+var duration = Number(argv.duration || 3000)
+
+// fs calls run on the libuv threadpool, make sure it does not cap concurrency
+if (!process.env.UV_THREADPOOL_SIZE) process.env.UV_THREADPOOL_SIZE = Math.max(4, concurrency)
+
+var fuse = require('../')
+var fs = require('fs')
+var os = require('os')
+var path = require('path')
+
+var mnt = path.join(os.tmpdir(), 'fuse-bindings-bench-' + process.pid)
+var SMALL_FILES = 1000
+var SMALL = Buffer.alloc(4096, 'a')
+var BIG = Buffer.alloc(64 * 1024 * 1024, 'b')
+var DIRS = {'/dir-10k': names(10000), '/dir-100k': names(100000)}
+
+var workloads = [
+  {name: 'getattr', run: getattr},
+  {name: 'small-open-read-close', run: smallFiles},
+  {name: 'seq-read-1m', run: seqRead},
+  {name: 'rand-read-4k', run: randRead},
+  {name: 'write-4k', run: write4k},
+  {name: 'readdir-10k', run: readdir('dir-10k'), concurrency: 1},
+  {name: 'readdir-100k', run: readdir('dir-100k'), concurrency: 1}
+]
+
+var now = new Date()
+var root = stat(16877, 4096)
+var small = stat(33188, SMALL.length)
+var big = stat(33188, BIG.length)
+var sink = stat(33188, 0)
+var dir = stat(16877, 4096)
+
+var ops = {
+  force: true,
+  multithreaded: !!argv.multithreaded,
+  getattr: function (name, cb) {
+    if (name === '/') return cb(0, root)
+    if (name === '/big') return cb(0, big)
+    if (name === '/sink') return cb(0, sink)
+    if (DIRS[name]) return cb(0, dir)
+    if (name.indexOf('/small-') === 0) return cb(0, small)
+    if (name.indexOf('/dir-') === 0) return cb(0, small)
+    cb(fuse.ENOENT)
+  },
+  readdir: function (name, cb) {
+    if (name === '/') return cb(0, ['big', 'sink'].concat(Object.keys(DIRS).map(function (d) { return d.slice(1) })))
+    if (DIRS[name]) return cb(0, DIRS[name])
+    cb(fuse.ENOENT)
+  },
+  open: function (name, flags, cb) {
+    cb(0, name === '/big' ? 1 : 2)
+  },
+  read: function (name, fd, buf, len, pos, cb) {
+    var data = fd === 1 ? BIG : SMALL
+    if (pos >= data.length) return cb(0)
+    cb(data.copy(buf, 0, pos, Math.min(data.length, pos + len)))
+  },
+  write: function (name, fd, buf, len, pos, cb) {
+    cb(len)
+  },
+  truncate: function (name, size, cb) {
+    cb(0)
+  },
+  release: function (name, fd, cb) {
+    cb(0)
+  }
+}
+
+// by default every stat goes through the bindings instead of being answered by the kernel
+if (!argv['kernel-cache']) ops.attrTimeout = ops.entryTimeout = 0
+
+try {
+  fs.mkdirSync(mnt)
+} catch (err) {
+  // do nothing
+}
+
+fuse.mount(mnt, ops, function (err) {
+  if (err) throw err
+
+  var results = {}
+  var list = workloads.filter(function (w) {
+    return !argv.filter || w.name.indexOf(argv.filter) > -1
+  })
+
+  loop()
+
+  function loop () {
+    var w = list.shift()
+    if (!w) return done()
+
+    measure(w, function (err, result) {
+      if (err) result = {error: err.message}
+      results[w.name] = result
+      loop()
+    })
+  }
+
+  function done () {
+    fuse.unmount(mnt, function () {
+      try {
+        fs.rmdirSync(mnt)
+      } catch (err) {
+        // do nothing
+      }
+      console.log(JSON.stringify({
+        node: process.version,
+        platform: os.platform(),
+        concurrency: concurrency,
+        duration: duration,
+        multithreaded: ops.multithreaded,
+        kernelCache: !!argv['kernel-cache'],
+        results: results
+      }, null, 2))
+    })
+  }
+})
+
+function measure (w, cb) {
+  var samples = []
+  var start = Date.now()
+  var workers = w.concurrency || concurrency
+  var missing = workers
+  var error = null
+  var states = []
+
+  for (var i = 0; i < workers; i++) worker(i)
+
+  function worker (id) {
+    var state = {id: id, n: 0}
+    states.push(state)
+
+    next()
+
+    function next () {
+      if (error || Date.now() - start >= duration) return finish()
+      var t = process.hrtime()
+      w.run(state, function (err) {
+        if (err) error = err
+        var d = process.hrtime(t)
+        samples.push(d[0] * 1e6 + d[1] / 1e3)
+        state.n++
+        next()
+      })
+    }
+  }
+
+  function finish () {
+    if (--missing) return
+
+    // open files would keep the mount busy
+    states.forEach(function (state) {
+      if (state.fd !== undefined) fs.closeSync(state.fd)
+    })
+
+    if (error) return cb(error)
+
+    var elapsed = (Date.now() - start) / 1000
+    samples.sort(function (a, b) { return a - b })
+
+    cb(null, {
+      ops: samples.length,
+      opsPerSec: Math.round(samples.length / elapsed),
+      p50: percentile(samples, 0.5),
+      p99: percentile(samples, 0.99),
+      p999: percentile(samples, 0.999),
+      unit: 'us'
+    })
+  }
+}
+
+function getattr (state, cb) {
+  fs.stat(path.join(mnt, 'small-' + (state.n % SMALL_FILES)), cb)
+}
+
+function smallFiles (state, cb) {
+  var buf = Buffer.alloc(SMALL.length)
+  fs.open(path.join(mnt, 'small-' + ((state.id * 31 + state.n) % SMALL_FILES)), 'r', function (err, fd) {
+    if (err) return cb(err)
+    fs.read(fd, buf, 0, buf.length, 0, function (err) {
+      fs.close(fd, function () {
+        cb(err)
+      })
+    })
+  })
+}
+
+function seqRead (state, cb) {
+  withFd(state, 'big', 'r', function (err, fd) {
+    if (err) return cb(err)
+    if (!state.buf) state.buf = Buffer.alloc(1024 * 1024)
+    var pos = (state.n * state.buf.length) % BIG.length
+    fs.read(fd, state.buf, 0, state.buf.length, pos, cb)
+  })
+}
+
+function randRead (state, cb) {
+  withFd(state, 'big', 'r', function (err, fd) {
+    if (err) return cb(err)
+    if (!state.buf) state.buf = Buffer.alloc(4096)
+    var pos = Math.floor(Math.random() * (BIG.length / 4096)) * 4096
+    fs.read(fd, state.buf, 0, state.buf.length, pos, cb)
+  })
+}
+
+function write4k (state, cb) {
+  withFd(state, 'sink', 'r+', function (err, fd) {
+    if (err) return cb(err)
+    fs.write(fd, SMALL, 0, SMALL.length, state.n * SMALL.length, cb)
+  })
+}
+
+function readdir (name) {
+  return function (state, cb) {
+    fs.readdir(path.join(mnt, name), cb)
+  }
+}
+
+function withFd (state, name, flags, cb) {
+  if (state.fd !== undefined) return cb(null, state.fd)
+  fs.open(path.join(mnt, name), flags, function (err, fd) {
+    if (err) return cb(err)
+    state.fd = fd
+    cb(null, fd)
+  })
+}
+
+function percentile (sorted, p) {
+  if (!sorted.length) return 0
+  return Math.round(sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))] * 10) / 10
+}
+
+function stat (mode, size) {
+  return {mtime: now, atime: now, ctime: now, mode: mode, size: size, uid: process.getuid(), gid: process.getgid()}
+}
+
+function names (n) {
+  var list = new Array(n)
+  for (var i = 0; i < n; i++) list[i] = 'file-' + i
+  return list
+}
+
+function parseArgs (args) {
+  var result = {}
+  args.forEach(function (arg) {
+    var m = arg.match(/^--([^=]+)(?:=(.*))?$/)
+    if (m) result[m[1]] = m[2] === undefined ? true : m[2]
+  })
+  return result
+}
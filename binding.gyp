@@ -1,7 +1,7 @@
 {
     "targets": [{
         "target_name": "fuse_bindings",
-        "sources": ["fuse-bindings.cc", "abstractions.cc"],
+        "sources": ["fuse-bindings.cc", "abstractions.cc", "cache.cc", "matcher.cc"],
         "include_dirs": [
             "<!(node -e \"require('nan')\")"
         ],
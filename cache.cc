@@ -0,0 +1,236 @@
+#include "cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct cache_entry_t {
+  cache_entry_t *next; // bucket chain
+  cache_entry_t *lru_prev;
+  cache_entry_t *lru_next;
+  uint32_t hash;
+  uint64_t expires;
+  size_t key_length;
+  size_t value_size;
+  char data[1]; // key followed by value
+};
+
+static uint32_t cache_hash (const void *key, size_t key_length) {
+  // fnv-1a
+  const unsigned char *k = (const unsigned char *) key;
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < key_length; i++) {
+    hash ^= k[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static size_t cache_entry_size (size_t key_length, size_t value_size) {
+  return sizeof(cache_entry_t) + key_length + value_size;
+}
+
+static void cache_lru_unlink (cache_t *cache, cache_entry_t *e) {
+  if (e->lru_prev != NULL) e->lru_prev->lru_next = e->lru_next;
+  else cache->head = e->lru_next;
+  if (e->lru_next != NULL) e->lru_next->lru_prev = e->lru_prev;
+  else cache->tail = e->lru_prev;
+}
+
+static void cache_lru_push (cache_t *cache, cache_entry_t *e) {
+  e->lru_prev = NULL;
+  e->lru_next = cache->head;
+  if (cache->head != NULL) cache->head->lru_prev = e;
+  cache->head = e;
+  if (cache->tail == NULL) cache->tail = e;
+}
+
+static cache_entry_t **cache_find (cache_t *cache, const void *key, size_t key_length, uint32_t hash) {
+  cache_entry_t **e = cache->buckets + (hash & (cache->buckets_length - 1));
+  while (*e != NULL) {
+    if ((*e)->hash == hash && (*e)->key_length == key_length && !memcmp((*e)->data, key, key_length)) break;
+    e = &((*e)->next);
+  }
+  return e;
+}
+
+static void cache_remove (cache_t *cache, cache_entry_t **ptr) {
+  cache_entry_t *e = *ptr;
+  *ptr = e->next;
+  cache_lru_unlink(cache, e);
+  cache->length--;
+  cache->size -= cache_entry_size(e->key_length, e->value_size);
+  if (cache->on_free != NULL) cache->on_free(e->data + e->key_length, e->value_size);
+  free(e);
+}
+
+static void cache_grow (cache_t *cache) {
+  uint32_t length = cache->buckets_length * 2;
+  cache_entry_t **buckets = (cache_entry_t **) calloc(length, sizeof(cache_entry_t *));
+
+  for (uint32_t i = 0; i < cache->buckets_length; i++) {
+    cache_entry_t *e = cache->buckets[i];
+    while (e != NULL) {
+      cache_entry_t *next = e->next;
+      cache_entry_t **bucket = buckets + (e->hash & (length - 1));
+      e->next = *bucket;
+      *bucket = e;
+      e = next;
+    }
+  }
+
+  free(cache->buckets);
+  cache->buckets = buckets;
+  cache->buckets_length = length;
+}
+
+void cache_init (cache_t *cache, size_t max_size, cache_free_fn on_free) {
+  memset(cache, 0, sizeof(cache_t));
+  mutex_init(&(cache->lock));
+  cache->buckets_length = 64;
+  cache->buckets = (cache_entry_t **) calloc(cache->buckets_length, sizeof(cache_entry_t *));
+  cache->max_size = max_size;
+  cache->on_free = on_free;
+}
+
+void cache_destroy (cache_t *cache) {
+  cache_clear(cache);
+  free(cache->buckets);
+  mutex_destroy(&(cache->lock));
+}
+
+void cache_put (cache_t *cache, const void *key, size_t key_length, const void *value, size_t value_size, uint64_t expires) {
+  size_t size = cache_entry_size(key_length, value_size);
+
+  // the old value is stale either way
+  if (size > cache->max_size) {
+    cache_del(cache, key, key_length);
+    return;
+  }
+
+  uint32_t hash = cache_hash(key, key_length);
+  cache_entry_t *e = (cache_entry_t *) malloc(size);
+  e->hash = hash;
+  e->expires = expires;
+  e->key_length = key_length;
+  e->value_size = value_size;
+  memcpy(e->data, key, key_length);
+  if (value_size) memcpy(e->data + key_length, value, value_size);
+
+  mutex_lock(&(cache->lock));
+
+  cache_entry_t **ptr = cache_find(cache, key, key_length, hash);
+  if (*ptr != NULL) cache_remove(cache, ptr);
+
+  while (cache->tail != NULL && cache->size + size > cache->max_size) {
+    cache_entry_t *tail = cache->tail;
+    cache_remove(cache, cache_find(cache, tail->data, tail->key_length, tail->hash));
+    cache->evictions++;
+  }
+
+  if (cache->length >= cache->buckets_length) cache_grow(cache);
+
+  cache_entry_t **bucket = cache->buckets + (hash & (cache->buckets_length - 1));
+  e->next = *bucket;
+  *bucket = e;
+  cache_lru_push(cache, e);
+  cache->length++;
+  cache->size += size;
+
+  mutex_unlock(&(cache->lock));
+}
+
+// call with the lock held, counts the hit or miss and marks the entry as recently used
+static cache_entry_t *cache_hit (cache_t *cache, const void *key, size_t key_length, uint32_t hash) {
+  cache_entry_t **ptr = cache_find(cache, key, key_length, hash);
+  cache_entry_t *e = *ptr;
+
+  if (e != NULL && e->expires && e->expires < uv_hrtime()) {
+    cache_remove(cache, ptr);
+    e = NULL;
+  }
+
+  if (e == NULL) {
+    cache->misses++;
+    return NULL;
+  }
+
+  cache_lru_unlink(cache, e);
+  cache_lru_push(cache, e);
+  cache->hits++;
+  return e;
+}
+
+int cache_get (cache_t *cache, const void *key, size_t key_length, void *value, size_t *value_size) {
+  uint32_t hash = cache_hash(key, key_length);
+
+  mutex_lock(&(cache->lock));
+
+  cache_entry_t *e = cache_hit(cache, key, key_length, hash);
+  if (e != NULL) {
+    size_t size = e->value_size < *value_size ? e->value_size : *value_size;
+    if (size) memcpy(value, e->data + key_length, size);
+    *value_size = e->value_size;
+  }
+
+  mutex_unlock(&(cache->lock));
+  return e != NULL;
+}
+
+int cache_get_split (cache_t *cache, const void *key, size_t key_length, void *head, size_t head_size, void *rest, size_t *rest_size) {
+  uint32_t hash = cache_hash(key, key_length);
+
+  mutex_lock(&(cache->lock));
+
+  cache_entry_t *e = cache_hit(cache, key, key_length, hash);
+  if (e != NULL) {
+    const char *data = e->data + key_length;
+    size_t stored = e->value_size > head_size ? e->value_size - head_size : 0;
+    size_t size = stored < *rest_size ? stored : *rest_size;
+
+    memcpy(head, data, e->value_size < head_size ? e->value_size : head_size);
+    if (size) memcpy(rest, data + head_size, size);
+    *rest_size = stored;
+  }
+
+  mutex_unlock(&(cache->lock));
+  return e != NULL;
+}
+
+int cache_del (cache_t *cache, const void *key, size_t key_length) {
+  uint32_t hash = cache_hash(key, key_length);
+
+  mutex_lock(&(cache->lock));
+  cache_entry_t **ptr = cache_find(cache, key, key_length, hash);
+  int found = *ptr != NULL;
+  if (found) cache_remove(cache, ptr);
+  mutex_unlock(&(cache->lock));
+
+  return found;
+}
+
+uint32_t cache_del_prefix (cache_t *cache, const void *prefix, size_t prefix_length) {
+  uint32_t removed = 0;
+
+  mutex_lock(&(cache->lock));
+  cache_entry_t *e = cache->head;
+  while (e != NULL) {
+    cache_entry_t *next = e->lru_next;
+    if (e->key_length >= prefix_length && !memcmp(e->data, prefix, prefix_length)) {
+      cache_remove(cache, cache_find(cache, e->data, e->key_length, e->hash));
+      removed++;
+    }
+    e = next;
+  }
+  mutex_unlock(&(cache->lock));
+
+  return removed;
+}
+
+void cache_clear (cache_t *cache) {
+  mutex_lock(&(cache->lock));
+  while (cache->head != NULL) {
+    cache_entry_t *e = cache->head;
+    cache_remove(cache, cache_find(cache, e->data, e->key_length, e->hash));
+  }
+  mutex_unlock(&(cache->lock));
+}
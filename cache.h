@@ -0,0 +1,45 @@
+#ifndef FUSE_BINDINGS_CACHE_H
+#define FUSE_BINDINGS_CACHE_H
+
+#include "abstractions.h"
+
+// Bounded LRU map from binary keys to copied values. All functions are thread safe.
+
+typedef void (*cache_free_fn)(void *value, size_t value_size);
+
+struct cache_entry_t;
+
+struct cache_t {
+  abstr_mutex_t lock;
+  cache_entry_t **buckets;
+  uint32_t buckets_length;
+  uint32_t length;
+  size_t size;
+  size_t max_size;
+  cache_entry_t *head; // most recently used
+  cache_entry_t *tail;
+  cache_free_fn on_free;
+
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+};
+
+void cache_init (cache_t *cache, size_t max_size, cache_free_fn on_free);
+void cache_destroy (cache_t *cache);
+
+// expires is an absolute uv_hrtime() value, 0 never expires
+void cache_put (cache_t *cache, const void *key, size_t key_length, const void *value, size_t value_size, uint64_t expires);
+
+// copies at most *value_size bytes into value and sets *value_size to the stored size, returns 1 on a hit
+int cache_get (cache_t *cache, const void *key, size_t key_length, void *value, size_t *value_size);
+
+// like cache_get for values made of a fixed size head and a variable rest, each copied into its own buffer.
+// *rest_size is set to the stored size of the rest
+int cache_get_split (cache_t *cache, const void *key, size_t key_length, void *head, size_t head_size, void *rest, size_t *rest_size);
+
+int cache_del (cache_t *cache, const void *key, size_t key_length);
+uint32_t cache_del_prefix (cache_t *cache, const void *prefix, size_t prefix_length);
+void cache_clear (cache_t *cache);
+
+#endif
@@ -23,9 +23,23 @@
 #include <string.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <cmath>
 #include <sys/types.h>
 
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
 #include "abstractions.h"
+#include "cache.h"
+#include "matcher.h"
 
 using namespace v8;
 
@@ -67,30 +81,238 @@ enum bindings_ops_t {
   OP_SYMLINK,
   OP_MKDIR,
   OP_RMDIR,
-  OP_DESTROY
+  OP_DESTROY,
+  OP_LOOKUP,
+  OP_FORGET
 };
 
-static Nan::Persistent<Function> buffer_constructor;
-static Nan::Callback *callback_constructor;
-static struct FUSE_STAT empty_stat;
+#define BINDINGS_OPS_LENGTH (OP_FORGET + 1)
 
-struct bindings_t {
-  int index;
-  int gc;
+// keep in the same order as bindings_ops_t
+static const char *bindings_ops_names[BINDINGS_OPS_LENGTH] = {
+  "init", "error", "access", "statfs", "fgetattr", "getattr", "flush", "fsync", "fsyncdir", "readdir",
+  "truncate", "ftruncate", "utimens", "readlink", "chown", "chmod", "mknod", "setxattr", "getxattr",
+  "listxattr", "removexattr", "open", "opendir", "read", "write", "release", "releasedir", "create",
+  "unlink", "rename", "link", "symlink", "mkdir", "rmdir", "destroy", "lookup", "forget"
+};
+
+// set up per isolate, the main thread and every worker thread that loads the bindings get their own
+static THREAD_LOCAL Nan::Persistent<Function> *buffer_constructor = NULL;
+static THREAD_LOCAL Nan::Callback *callback_constructor = NULL;
+
+#define BINDINGS_RING_SIZE 256 // must be a power of two
+#define BINDINGS_DEFERRED_MAX (BINDINGS_RING_SIZE / 2) // a burst of deferred requests leaves room for the ones that wait
+#define BINDINGS_FH_SLOT ((uint64_t) 1 << 63) // file handles with this bit set point into the file table
+#define BINDINGS_FH_TARGET(fh) ((uint32_t) ((fh) >> 55) & 0xff) // the thread whose file table it is
+#define BINDINGS_MAX_WORKERS 255
+
+#ifdef ENOATTR
+#define BINDINGS_ENOATTR ENOATTR
+#else
+#define BINDINGS_ENOATTR ENODATA
+#endif
+
+// log-linear latency histograms in ns, 8 buckets per power of two up to 2^36ns (~68s)
+#define BINDINGS_HIST_SUB_BITS 3
+#define BINDINGS_HIST_MAX_BIT 36
+#define BINDINGS_HIST_BUCKETS ((BINDINGS_HIST_MAX_BIT - BINDINGS_HIST_SUB_BITS + 2) << BINDINGS_HIST_SUB_BITS)
+
+struct bindings_hist_t {
+  volatile uint64_t count;
+  volatile uint64_t sum;
+  volatile uint64_t buckets[BINDINGS_HIST_BUCKETS];
+};
+
+struct bindings_op_stats_t {
+  bindings_hist_t queue; // from the fuse thread until dispatch on the js thread
+  bindings_hist_t handler; // from dispatch until the js callback
+  bindings_hist_t total; // full round trip as seen by the fuse thread
+  volatile uint32_t inflight;
+};
+
+struct bindings_t;
+
+// read_buf replies can point at a file descriptor instead of filling the buffer
+struct bindings_read_fd_t {
+  int fd;
+  FUSE_OFF_T position;
+};
+
+struct bindings_req_t;
+typedef void (*bindings_done_fn)(struct bindings_req_t *r);
+
+struct bindings_req_t {
+  bindings_t *b;
+  bindings_t *target; // where the request is dispatched, b unless it goes to a worker
+  bindings_req_t *next; // free list
+  bindings_req_t *dispatched_next; // handed to js on a worker thread and not answered yet
+  bindings_req_t **dispatched_prev;
+  Nan::Callback *callback;
+  bindings_sem_t semaphore;
+  bindings_done_fn done; // set for requests nobody waits for, called on the js thread instead
 
   // fuse context
   int context_uid;
   int context_gid;
   int context_pid;
 
+  // method data
+  bindings_ops_t op;
+  struct fuse_file_info *info;
+  struct fuse_file_info own_info; // for requests that outlive the fuse call
+  char *path;
+  char *name;
+  uint64_t ino; // used instead of path in lowlevel mode
+#ifndef _WIN32
+  fuse_req_t ll;
+#endif
+  FUSE_OFF_T offset;
+  FUSE_OFF_T length;
+  void *data; // various structs
+  bindings_read_fd_t *read_fd; // only set by read_buf
+  uint64_t time_call;
+  uint64_t time_dispatch;
+  uint32_t attr_gen; // b->attr_gen when the call was made
+  int mode;
+  int dev;
+  int uid;
+  int gid;
+  int result;
+};
+
+// write back buffer of an open file, contiguous writes are collected here and handed to js in one go
+struct bindings_wb_t {
+  bindings_wb_t *next;
+  char *path; // NULL in lowlevel mode
+  uint64_t ino;
+  uint64_t fh;
+  abstr_mutex_t lock;
+  uint32_t refs; // one for being in b->wb, guarded by b->wb_lock
+  char *data;
+  size_t length;
+  FUSE_OFF_T offset; // file position of data[0]
+  uint64_t time; // when the first buffered write arrived
+  int error; // from a write that was already acknowledged, reported by the next flush, fsync or release
+  int context_uid;
+  int context_gid;
+  int context_pid;
+};
+
+// an entry of the xattr policy table, name ends in * to match a prefix
+struct bindings_xattr_rule_t {
+  char *name;
+  size_t length; // without the *
+  int prefix;
+  int pass; // asked ops.getxattr
+  int result; // answer when there is no value, a negative errno
+  char *value;
+  size_t value_length;
+};
+
+// cached getxattr and listxattr results, the value follows when there is one
+struct bindings_xattr_entry_t {
+  int32_t result; // size of the value or a negative errno
+  int32_t has_value; // 0 if only the size was asked for
+};
+
+// readdir replies, the names are packed into one allocation separated by \0
+struct bindings_dir_t {
+  char *names;
+  uint32_t length;
+  struct FUSE_STAT *stats; // NULL if no stats were passed
+};
+
+struct bindings_ring_cell_t {
+  volatile uint32_t seq;
+  bindings_req_t *req;
+};
+
+struct bindings_t {
+  uint32_t hash; // of mnt, see bindings_registry_add
+  bindings_t *registry_next;
+  int gc;
+  int multithreaded;
+  int lowlevel;
+  int readdir_offset; // readdir handler takes an offset and returns pages
+  int null_path; // fh based ops get no path, see bindings_session_open
+  int zero_copy;
+
+  // read ahead block cache, keyed by path (or inode), fh and block number
+  cache_t *read_cache;
+  cache_t *read_state; // sequential read detection per open file
+  uint32_t read_block_size;
+  uint32_t read_ahead; // max blocks to prefetch ahead of a reader
+  abstr_mutex_t rc_lock; // guards read_state updates
+  volatile uint32_t prefetching;
+  volatile uint64_t prefetches;
+
+  // release and friends are answered right away and run in js later, at most deferred_max at a time
+  uint32_t deferred_max; // 0 if disabled
+  int deferred_flush;
+  volatile uint32_t deferred;
+  volatile uint64_t deferred_total;
+  volatile uint64_t deferred_overflows; // ran synchronously because the queue was full
+
+  // write back buffers, only used when write_buffer_size > 0
+  uint32_t write_buffer_size;
+  uint64_t write_buffer_delay;
+  abstr_mutex_t wb_lock;
+  abstr_thread_t wb_thread; // writes out buffers of idle files, see bindings_wb_thread
+  volatile uint32_t wb_stop;
+  bindings_wb_t *wb;
+
+  // connection capabilities requested at init, 0 leaves the kernel default
+  uint32_t max_write;
+  uint32_t max_readahead;
+  uint32_t conn_want;
+  uint32_t conn_unwant;
+
+  // kernel cache timeouts in seconds
+  double attr_timeout;
+  double entry_timeout;
+  double negative_timeout;
+
+  // native attribute cache, keyed by path or by inode in lowlevel mode
+  cache_t *attr_cache;
+  double attr_cache_ttl;
+  volatile uint32_t attr_gen; // bumped before an op drops cached attributes or missing paths
+
+  // recently used path strings, only touched on the js thread
+  cache_t *path_cache;
+
+  // paths known not to exist, answered with ENOENT without calling into js
+  matcher_t *negative_rules;
+  cache_t *negative_cache; // misses learned from getattr, keyed by path
+  double negative_cache_ttl;
+
+  // xattr names answered natively, and cached results keyed by path\0name (high level mode only)
+  bindings_xattr_rule_t *xattr_rules;
+  uint32_t xattr_rules_length;
+  cache_t *xattr_cache;
+  double xattr_cache_ttl;
+
   // fuse data
-  char mnt[1024];
-  char mntopts[1024];
+  char *mnt;
+  char *mntopts;
   abstr_thread_t thread;
-  bindings_sem_t semaphore;
-  bindings_sem_t semaphore_readdir;
+  struct fuse *fuse; // high level mode only
+  struct fuse_session *se;
+  struct fuse_chan *ch; // kernel connection for notifications, guarded by the global mutex
   uv_async_t async;
 
+  // served by the shared epoll driver instead of a thread of its own, see bindings_driver_thread
+  uint32_t shared; // size of the driver pool, 0 for a thread per mount
+  int stopped;
+  bindings_sem_t *unmounted; // signalled once the session is gone, guarded by the global mutex
+  bindings_t *driver_next;
+
+  // requests
+  abstr_mutex_t lock;
+  bindings_req_t *reqs_free;
+  bindings_ring_cell_t *ring;
+  volatile uint32_t ring_tail; // claimed by the fuse threads
+  uint32_t ring_head; // only touched by the loop
+
   // methods
   Nan::Callback *ops_init;
   Nan::Callback *ops_error;
@@ -127,58 +349,194 @@ struct bindings_t {
   Nan::Callback *ops_mkdir;
   Nan::Callback *ops_rmdir;
   Nan::Callback *ops_destroy;
+  Nan::Callback *ops_lookup;
+  Nan::Callback *ops_forget;
+
+  // latency stats indexed by bindings_ops_t, allocated on first use, see bindings_op_stats
+  bindings_op_stats_t **stats;
+  volatile uint32_t inflight;
+  volatile uint32_t queued;
+
+  // worker_threads that requests are dispatched to, see Attach
+  bindings_t *parent; // set on the dispatch targets owned by a worker
+  bindings_t **workers;
+  uint32_t workers_length;
+  volatile uint32_t workers_attached;
+  volatile uint32_t workers_next; // round robin
+  int workers_affinity; // route by path or inode instead
+  int target_index; // 0 for the mount itself, i + 1 for workers[i]
+  volatile uint32_t closing;
+  bindings_sem_t workers_closed; // signalled once per worker when it closes or detaches
+  volatile uint32_t detached; // the worker died, the mount thread fails its requests
+  volatile uint32_t senders; // threads waking the worker, see bindings_wakeup
+  bindings_req_t *dispatched; // only touched on the worker thread
+
+  // callers using b or its channel outside the global mutex, see bindings_pin
+  volatile uint32_t pins;
+
+  // values returned from open/create/opendir that do not fit in fh, only touched on the js thread
+  Nan::Persistent<Array> *files;
+  uint32_t *files_gen;
+  uint32_t *files_free;
+  uint32_t files_length;
+  uint32_t files_free_length;
+  uint32_t files_alloc;
+};
 
-  Nan::Callback *callback;
+static THREAD_LOCAL bindings_req_t *bindings_current = NULL;
 
-  // method data
-  bindings_ops_t op;
-  fuse_fill_dir_t filler; // used in readdir
-  struct fuse_file_info *info;
-  char *path;
-  char *name;
-  FUSE_OFF_T offset;
-  FUSE_OFF_T length;
-  void *data; // various structs
-  int mode;
-  int dev;
-  int uid;
-  int gid;
-  int result;
-};
+static uint32_t bindings_hash (const char *str) {
+  uint32_t hash = 2166136261u;
+  while (*str) hash = (hash ^ (uint8_t) *(str++)) * 16777619u;
+  return hash;
+}
+
+// every mount by the hash of its path, chained per bucket and guarded by the global mutex
+static bindings_t **bindings_registry = NULL;
+static uint32_t bindings_registry_size = 0; // power of two
+static uint32_t bindings_registry_count = 0;
+
+static void bindings_registry_add (bindings_t *b) {
+  if (bindings_registry_count >= bindings_registry_size / 2) {
+    uint32_t size = bindings_registry_size ? bindings_registry_size * 2 : 64;
+    bindings_t **registry = (bindings_t **) calloc(size, sizeof(bindings_t *));
+
+    for (uint32_t i = 0; i < bindings_registry_size; i++) {
+      bindings_t *next = bindings_registry[i];
+      while (next != NULL) {
+        bindings_t *e = next;
+        next = e->registry_next;
+        e->registry_next = registry[e->hash & (size - 1)];
+        registry[e->hash & (size - 1)] = e;
+      }
+    }
+
+    free(bindings_registry);
+    bindings_registry = registry;
+    bindings_registry_size = size;
+  }
+
+  b->hash = bindings_hash(b->mnt);
+  b->registry_next = bindings_registry[b->hash & (bindings_registry_size - 1)];
+  bindings_registry[b->hash & (bindings_registry_size - 1)] = b;
+  bindings_registry_count++;
+}
 
-static bindings_t *bindings_mounted[1024];
-static int bindings_mounted_count = 0;
-static bindings_t *bindings_current = NULL;
+static void bindings_registry_remove (bindings_t *b) {
+  bindings_t **e = bindings_registry + (b->hash & (bindings_registry_size - 1));
+  while (*e != b) e = &((*e)->registry_next);
+  *e = b->registry_next;
+  bindings_registry_count--;
+}
 
 static bindings_t *bindings_find_mounted (char *path) {
-  for (int i = 0; i < bindings_mounted_count; i++) {
-    bindings_t *b = bindings_mounted[i];
-    if (b != NULL && !b->gc && !strcmp(b->mnt, path)) {
-      return b;
-    }
+  if (bindings_registry_count == 0) return NULL;
+
+  uint32_t hash = bindings_hash(path);
+  for (bindings_t *b = bindings_registry[hash & (bindings_registry_size - 1)]; b != NULL; b = b->registry_next) {
+    if (b->hash == hash && !b->gc && !strcmp(b->mnt, path)) return b;
   }
   return NULL;
 }
 
+// keeps b and its channel alive after the global mutex is dropped, call with the mutex held.
+// teardown waits for the pins to go in bindings_pin_wait
+static bindings_t *bindings_pin (char *path) {
+  bindings_t *b = bindings_find_mounted(path);
+  if (b != NULL) atomic_add(&(b->pins), 1);
+  return b;
+}
+
+static void bindings_unpin (bindings_t *b) {
+  atomic_add(&(b->pins), -1);
+}
+
+static void bindings_pin_wait (bindings_t *b) {
+  while (atomic_get(&(b->pins)) > 0) thread_yield();
+}
+
 static int bindings_fusermount (char *path) {
   return fusermount(path);
 }
 
-static int bindings_unmount (char *path) {
+// an unmount is split in two so a batch can unmount everything before waiting for any session to end
+struct bindings_unmount_t {
+  int result;
+  int join;
+  int wait;
+  abstr_thread_t thread;
+  bindings_sem_t unmounted;
+};
+
+static void bindings_unmount_start (char *path, bindings_unmount_t *u) {
+  u->join = u->wait = 0;
+
   mutex_lock(&mutex);
-  bindings_t *b = bindings_find_mounted(path);
-  int result = bindings_fusermount(path);
-  if (b != NULL && result == 0) b->gc = 1;
+  bindings_t *b = bindings_pin(path);
   mutex_unlock(&mutex);
 
-  if (b != NULL && result == 0) thread_join(b->thread);
+  // this can fork and exec fusermount, so it runs without the mutex
+  u->result = bindings_fusermount(path);
+  if (b == NULL) return;
 
-  return result;
+  mutex_lock(&mutex);
+  if (u->result == 0) {
+    b->gc = 1;
+#ifndef _WIN32
+    // the kernel ends the connection as well, this makes sure the loop does not wait for another request
+    if (b->ch != NULL) fuse_session_exit(b->se);
+#endif
+    // b can be freed as soon as its session is done, so nothing is read from it after this
+    if (!b->shared) {
+      u->thread = b->thread;
+      u->join = 1;
+    } else if (!b->stopped) {
+      semaphore_init(&(u->unmounted));
+      b->unmounted = &(u->unmounted);
+      u->wait = 1;
+    }
+  }
+  mutex_unlock(&mutex);
+  bindings_unpin(b);
+}
+
+// unmountMany runs bindings_unmount_start on a few threads at once, each taking the next path
+#define BINDINGS_UNMOUNT_THREADS 16
+
+struct bindings_unmount_batch_t {
+  char **paths;
+  bindings_unmount_t *unmounts;
+  uint32_t length;
+  volatile uint32_t next;
+};
+
+static thread_fn_rtn_t bindings_unmount_batch_thread (void *data) {
+  bindings_unmount_batch_t *batch = (bindings_unmount_batch_t *) data;
+  uint32_t i;
+  while ((i = atomic_add(&(batch->next), 1) - 1) < batch->length) {
+    bindings_unmount_start(batch->paths[i], batch->unmounts + i);
+  }
+  return 0;
+}
+
+static int bindings_unmount_finish (bindings_unmount_t *u) {
+  if (u->join) thread_join(u->thread);
+  if (u->wait) {
+    semaphore_wait(&(u->unmounted));
+    semaphore_destroy(&(u->unmounted));
+  }
+  return u->result;
+}
+
+static int bindings_unmount (char *path) {
+  bindings_unmount_t u;
+  bindings_unmount_start(path, &u);
+  return bindings_unmount_finish(&u);
 }
 
 #if (NODE_MODULE_VERSION > NODE_0_10_MODULE_VERSION && NODE_MODULE_VERSION < IOJS_3_0_MODULE_VERSION)
 NAN_INLINE v8::Local<v8::Object> bindings_buffer (char *data, size_t length) {
-  Local<Object> buf = Nan::New(buffer_constructor)->NewInstance(0, NULL);
+  Local<Object> buf = Nan::New(*buffer_constructor)->NewInstance(0, NULL);
   Local<String> k = LOCAL_STRING("length");
   Local<Number> v = Nan::New<Number>(length);
   buf->Set(k, v);
@@ -192,422 +550,2078 @@ NAN_INLINE v8::Local<v8::Object> bindings_buffer (char *data, size_t length) {
 }
 #endif
 
-NAN_INLINE static int bindings_call_ex (bindings_t *b, bool isreaddir) {
-  uv_async_send(&(b->async));
-  if (isreaddir) {
-    semaphore_wait(&(b->semaphore_readdir));  
-  } else {
-    semaphore_wait(&(b->semaphore));  
+static bindings_req_t *bindings_req_alloc (bindings_t *b) {
+  mutex_lock(&(b->lock));
+  bindings_req_t *r = b->reqs_free;
+  if (r != NULL) b->reqs_free = r->next;
+  mutex_unlock(&(b->lock));
+
+  if (r == NULL) {
+    r = (bindings_req_t *) malloc(sizeof(bindings_req_t));
+    memset(r, 0, sizeof(bindings_req_t));
+    r->b = b;
+    semaphore_init(&(r->semaphore));
   }
 
-  return b->result;
+  return r;
 }
 
-NAN_INLINE static int bindings_call (bindings_t *b) {
-  return bindings_call_ex(b, false);
+static void bindings_req_free (bindings_req_t *r) {
+  bindings_t *b = r->b;
+
+  r->dispatched_prev = NULL;
+  r->read_fd = NULL;
+  r->info = NULL;
+  r->done = NULL;
+
+  mutex_lock(&(b->lock));
+  r->next = b->reqs_free;
+  b->reqs_free = r;
+  mutex_unlock(&(b->lock));
 }
 
-static bindings_t *bindings_get_context () {
-  fuse_context *ctx = fuse_get_context();
-  bindings_t *b = (bindings_t *) ctx->private_data;
-  b->context_pid = ctx->pid;
-  b->context_uid = ctx->uid;
-  b->context_gid = ctx->gid;
-  return b;
+static void bindings_ring_init (bindings_t *b) {
+  b->ring = (bindings_ring_cell_t *) malloc(sizeof(bindings_ring_cell_t) * BINDINGS_RING_SIZE);
+  for (uint32_t i = 0; i < BINDINGS_RING_SIZE; i++) {
+    b->ring[i].seq = i;
+    b->ring[i].req = NULL;
+  }
+  b->ring_tail = 0;
+  b->ring_head = 0;
 }
 
-static int bindings_mknod (const char *path, mode_t mode, dev_t dev) {
-  bindings_t *b = bindings_get_context();
+// bounded mpsc queue, every fuse thread can push but only the loop shifts
+static void bindings_ring_push (bindings_t *b, bindings_req_t *r) {
+  uint32_t pos = atomic_get(&(b->ring_tail));
 
-  b->op = OP_MKNOD;
-  b->path = (char *) path;
-  b->mode = mode;
-  b->dev = dev;
+  while (true) {
+    bindings_ring_cell_t *cell = b->ring + (pos & (BINDINGS_RING_SIZE - 1));
+    int32_t diff = (int32_t) (atomic_get(&(cell->seq)) - pos);
+
+    if (diff == 0 && atomic_cas(&(b->ring_tail), pos, pos + 1)) {
+      cell->req = r;
+      atomic_set(&(cell->seq), pos + 1);
+      return;
+    }
 
-  return bindings_call(b);
+    if (diff < 0) thread_yield(); // full, wait for the loop to drain it
+    pos = atomic_get(&(b->ring_tail));
+  }
 }
 
-static int bindings_truncate (const char *path, FUSE_OFF_T size) {
-  bindings_t *b = bindings_get_context();
+static bindings_req_t *bindings_ring_shift (bindings_t *b) {
+  bindings_ring_cell_t *cell = b->ring + (b->ring_head & (BINDINGS_RING_SIZE - 1));
+  if ((int32_t) (atomic_get(&(cell->seq)) - (b->ring_head + 1)) < 0) return NULL;
 
-  b->op = OP_TRUNCATE;
-  b->path = (char *) path;
-  b->length = size;
+  bindings_req_t *r = cell->req;
+  atomic_set(&(cell->seq), b->ring_head + BINDINGS_RING_SIZE);
+  b->ring_head++;
 
-  return bindings_call(b);
+  return r;
 }
 
-static int bindings_ftruncate (const char *path, FUSE_OFF_T size, struct fuse_file_info *info) {
-  bindings_t *b = bindings_get_context();
+static int bindings_hist_index (uint64_t ns) {
+  if (ns < (1 << BINDINGS_HIST_SUB_BITS)) return (int) ns;
 
-  b->op = OP_FTRUNCATE;
-  b->path = (char *) path;
-  b->length = size;
-  b->info = info;
+  int msb = 0;
+  uint64_t v = ns;
+  if (v >> 32) { v >>= 32; msb += 32; }
+  if (v >> 16) { v >>= 16; msb += 16; }
+  if (v >> 8) { v >>= 8; msb += 8; }
+  if (v >> 4) { v >>= 4; msb += 4; }
+  if (v >> 2) { v >>= 2; msb += 2; }
+  if (v >> 1) msb += 1;
 
-  return bindings_call(b);
-}
+  if (msb > BINDINGS_HIST_MAX_BIT) return BINDINGS_HIST_BUCKETS - 1;
 
-static int bindings_getattr (const char *path, struct FUSE_STAT *stat) {
-  bindings_t *b = bindings_get_context();
+  int sub = (int) (ns >> (msb - BINDINGS_HIST_SUB_BITS)) & ((1 << BINDINGS_HIST_SUB_BITS) - 1);
+  return ((msb - BINDINGS_HIST_SUB_BITS + 1) << BINDINGS_HIST_SUB_BITS) + sub;
+}
 
-  b->op = OP_GETATTR;
-  b->path = (char *) path;
-  b->data = stat;
+// midpoint of the values that land in a bucket
+static double bindings_hist_value (int index) {
+  if (index < (1 << BINDINGS_HIST_SUB_BITS)) return index;
 
-  return bindings_call(b);
+  int msb = (index >> BINDINGS_HIST_SUB_BITS) + BINDINGS_HIST_SUB_BITS - 1;
+  int sub = index & ((1 << BINDINGS_HIST_SUB_BITS) - 1);
+  double width = (double) ((uint64_t) 1 << (msb - BINDINGS_HIST_SUB_BITS));
+  return (double) (((uint64_t) 1 << msb) + sub * (uint64_t) width) + width / 2;
 }
 
-static int bindings_fgetattr (const char *path, struct FUSE_STAT *stat, struct fuse_file_info *info) {
-  bindings_t *b = bindings_get_context();
+NAN_INLINE static void bindings_hist_record (bindings_hist_t *h, uint64_t ns) {
+  atomic_add64(&(h->count), 1);
+  atomic_add64(&(h->sum), ns);
+  atomic_add64(&(h->buckets[bindings_hist_index(ns)]), 1);
+}
 
-  b->op = OP_FGETATTR;
-  b->path = (char *) path;
-  b->data = stat;
-  b->info = info;
+// fuse threads keep counting while a counter is reset, taking off what was read keeps their updates
+NAN_INLINE static void bindings_counter_reset (volatile uint64_t *counter) {
+  uint64_t seen = *counter;
+  if (seen) atomic_add64(counter, -(int64_t) seen);
+}
 
-  return bindings_call(b);
+static void bindings_hist_reset (bindings_hist_t *h) {
+  bindings_counter_reset(&(h->count));
+  bindings_counter_reset(&(h->sum));
+  for (int i = 0; i < BINDINGS_HIST_BUCKETS; i++) bindings_counter_reset(&(h->buckets[i]));
 }
 
-static int bindings_flush (const char *path, struct fuse_file_info *info) {
-  bindings_t *b = bindings_get_context();
+static bindings_t *bindings_route (bindings_t *b, bindings_req_t *r) {
+  if (b->workers_length == 0 || r->op == OP_INIT || r->op == OP_ERROR || r->op == OP_DESTROY) return b;
+
+  // handles kept in a file table have to go back to the thread that owns the table
+  if (r->info != NULL && (r->info->fh & BINDINGS_FH_SLOT)) {
+    uint32_t target = BINDINGS_FH_TARGET(r->info->fh);
+    if (target == 0 || target > b->workers_length) return b;
+    return b->workers[target - 1];
+  }
 
-  b->op = OP_FLUSH;
-  b->path = (char *) path;
-  b->info = info;
+  uint32_t i;
+  if (!b->workers_affinity) i = atomic_add(&(b->workers_next), 1);
+  else if (b->lowlevel) i = (uint32_t) (r->ino * 2654435761u);
+  else if (r->path != NULL) i = bindings_hash(r->path);
+  else i = r->info != NULL ? (uint32_t) r->info->fh : 0;
 
-  return bindings_call(b);
+  return b->workers[i % b->workers_length];
 }
 
-static int bindings_fsync (const char *path, int datasync, struct fuse_file_info *info) {
-  bindings_t *b = bindings_get_context();
+// most mounts only ever see a handful of ops, so the histograms are allocated on first use
+static bindings_op_stats_t *bindings_op_stats (bindings_t *b, int op) {
+  bindings_op_stats_t *stats = b->stats[op];
+  if (stats != NULL) return stats;
 
-  b->op = OP_FSYNC;
-  b->path = (char *) path;
-  b->mode = datasync;
-  b->info = info;
+  stats = (bindings_op_stats_t *) calloc(1, sizeof(bindings_op_stats_t));
+  if (atomic_cas_ptr((void * volatile *) (b->stats + op), NULL, stats)) return stats;
 
-  return bindings_call(b);
+  free(stats);
+  return b->stats[op];
 }
 
-static int bindings_fsyncdir (const char *path, int datasync, struct fuse_file_info *info) {
-  bindings_t *b = bindings_get_context();
-
-  b->op = OP_FSYNCDIR;
-  b->path = (char *) path;
-  b->mode = datasync;
-  b->info = info;
+// the loop of a worker can go away at any time, so it is only woken while it is known to be alive
+static void bindings_wakeup (bindings_t *t) {
+  if (t->parent == NULL) {
+    uv_async_send(&(t->async));
+    return;
+  }
 
-  return bindings_call(b);
+  atomic_add(&(t->senders), 1);
+  if (!atomic_get(&(t->detached))) uv_async_send(&(t->async));
+  else uv_async_send(&(t->parent->async)); // fails what is queued for t
+  atomic_add(&(t->senders), -1);
 }
 
-static int bindings_readdir (const char *path, void *buf, fuse_fill_dir_t filler, FUSE_OFF_T offset, struct fuse_file_info *info) {
-  bindings_t *b = bindings_get_context();
+static void bindings_call_start (bindings_req_t *r) {
+  bindings_t *b = r->b;
+  bindings_t *t = r->target = bindings_route(b, r);
+  bindings_op_stats_t *stats = bindings_op_stats(b, r->op);
 
-  b->op = OP_READDIR;
-  b->path = (char *) path;
-  b->data = buf;
-  b->filler = filler;
+  atomic_add(&(b->inflight), 1);
+  atomic_add(&(b->queued), 1);
+  atomic_add(&(stats->inflight), 1);
+  r->time_call = uv_hrtime();
+  r->attr_gen = atomic_get(&(b->attr_gen));
 
-  return bindings_call_ex(b, true);
+  bindings_ring_push(t, r);
+  bindings_wakeup(t);
 }
 
-static int bindings_readlink (const char *path, char *buf, size_t len) {
-  bindings_t *b = bindings_get_context();
-
-  b->op = OP_READLINK;
-  b->path = (char *) path;
-  b->data = (void *) buf;
-  b->length = len;
+static void bindings_call_end (bindings_req_t *r) {
+  bindings_t *b = r->b;
+  bindings_op_stats_t *stats = bindings_op_stats(b, r->op);
 
-  return bindings_call(b);
+  bindings_hist_record(&(stats->total), uv_hrtime() - r->time_call);
+  atomic_add(&(stats->inflight), -1);
+  atomic_add(&(b->inflight), -1);
 }
 
-static int bindings_chown (const char *path, uid_t uid, gid_t gid) {
-  bindings_t *b = bindings_get_context();
+static int bindings_call (bindings_req_t *r) {
+  bindings_call_start(r);
+  semaphore_wait(&(r->semaphore));
+  bindings_call_end(r);
 
-  b->op = OP_CHOWN;
-  b->path = (char *) path;
-  b->uid = uid;
-  b->gid = gid;
+  int result = r->result;
+  bindings_req_free(r);
+  return result;
+}
 
-  return bindings_call(b);
+// queues r without waiting for it, done is called on the js thread once it has a result and owns r from then on
+static void bindings_call_async (bindings_req_t *r, bindings_done_fn done) {
+  r->done = done;
+  bindings_call_start(r);
 }
 
-static int bindings_chmod (const char *path, mode_t mode) {
-  bindings_t *b = bindings_get_context();
+static void bindings_req_done (bindings_req_t *r) {
+  if (r->dispatched_prev != NULL) {
+    *(r->dispatched_prev) = r->dispatched_next;
+    if (r->dispatched_next != NULL) r->dispatched_next->dispatched_prev = r->dispatched_prev;
+    r->dispatched_prev = NULL;
+  }
 
-  b->op = OP_CHMOD;
-  b->path = (char *) path;
-  b->mode = mode;
+  if (r->done == NULL) {
+    semaphore_signal(&(r->semaphore));
+    return;
+  }
 
-  return bindings_call(b);
+  bindings_call_end(r);
+  r->done(r);
 }
 
-#ifdef __APPLE__
-static int bindings_setxattr (const char *path, const char *name, const char *value, size_t size, int flags, uint32_t position) {
-  bindings_t *b = bindings_get_context();
+static void bindings_defer_done (bindings_req_t *r) {
+  bindings_t *b = r->b;
 
-  b->op = OP_SETXATTR;
-  b->path = (char *) path;
-  b->name = (char *) name;
-  b->data = (void *) value;
-  b->length = size;
-  b->offset = position;
-  b->mode = flags;
+  free(r->path);
+  r->path = NULL;
 
-  return bindings_call(b);
+  atomic_add(&(b->deferred), -1);
+  bindings_req_free(r);
 }
 
-static int bindings_getxattr (const char *path, const char *name, char *value, size_t size, uint32_t position) {
-  bindings_t *b = bindings_get_context();
+// queues a request whose result the kernel ignores without waiting for it
+// returns 0 if r has to be called as usual, when the option is off or too many are pending
+static int bindings_defer (bindings_req_t *r) {
+  bindings_t *b = r->b;
+  if (b->deferred_max == 0) return 0;
 
-  b->op = OP_GETXATTR;
-  b->path = (char *) path;
-  b->name = (char *) name;
-  b->data = (void *) value;
-  b->length = size;
-  b->offset = position;
+  if (atomic_add(&(b->deferred), 1) > b->deferred_max) {
+    atomic_add(&(b->deferred), -1);
+    atomic_add64(&(b->deferred_overflows), 1);
+    return 0;
+  }
 
-  return bindings_call(b);
-}
-#else
-static int bindings_setxattr (const char *path, const char *name, const char *value, size_t size, int flags) {
-  bindings_t *b = bindings_get_context();
+  // the fuse buffers are gone by the time js sees the request
+  if (r->path != NULL) r->path = strdup(r->path);
+  if (r->info != NULL) {
+    r->own_info = *(r->info);
+    r->info = &(r->own_info);
+  }
 
-  b->op = OP_SETXATTR;
-  b->path = (char *) path;
-  b->name = (char *) name;
-  b->data = (void *) value;
-  b->length = size;
-  b->offset = 0;
-  b->mode = flags;
+  atomic_add64(&(b->deferred_total), 1);
+  bindings_call_async(r, bindings_defer_done);
+  return 1;
+}
 
-  return bindings_call(b);
+static bindings_req_t *bindings_get_context () {
+  fuse_context *ctx = fuse_get_context();
+  bindings_req_t *r = bindings_req_alloc((bindings_t *) ctx->private_data);
+  r->context_pid = ctx->pid;
+  r->context_uid = ctx->uid;
+  r->context_gid = ctx->gid;
+  return r;
 }
 
-static int bindings_getxattr (const char *path, const char *name, char *value, size_t size) {
-  bindings_t *b = bindings_get_context();
+// without a path the buffer could belong to any file, so it is flushed with all of them
+NAN_INLINE static bool bindings_wb_match (bindings_t *b, bindings_wb_t *wb, const char *path, uint64_t ino) {
+  if (b->lowlevel) return wb->ino == ino;
+  return wb->path == NULL || path == NULL || !strcmp(wb->path, path);
+}
 
-  b->op = OP_GETXATTR;
-  b->path = (char *) path;
-  b->name = (char *) name;
-  b->data = (void *) value;
-  b->length = size;
-  b->offset = 0;
+static void bindings_wb_destroy (bindings_wb_t *wb) {
+  mutex_destroy(&(wb->lock));
+  free(wb->path);
+  free(wb->data);
+  free(wb);
+}
 
-  return bindings_call(b);
+// returns the buffer of an open file with a reference taken, call with b->wb_lock held
+static bindings_wb_t *bindings_wb_find (bindings_t *b, const char *path, uint64_t ino, uint64_t fh) {
+  for (bindings_wb_t *wb = b->wb; wb != NULL; wb = wb->next) {
+    if (wb->fh != fh || !bindings_wb_match(b, wb, path, ino)) continue;
+    wb->refs++;
+    return wb;
+  }
+  return NULL;
 }
-#endif
 
-static int bindings_listxattr (const char *path, char *list, size_t size) {
-  bindings_t *b = bindings_get_context();
+static void bindings_wb_put (bindings_t *b, bindings_wb_t *wb) {
+  mutex_lock(&(b->wb_lock));
+  uint32_t refs = --(wb->refs);
+  mutex_unlock(&(b->wb_lock));
+  if (refs == 0) bindings_wb_destroy(wb);
+}
 
-  b->op = OP_LISTXATTR;
-  b->path = (char *) path;
-  b->data = (void *) list;
-  b->length = size;
+// hands the buffered data to the write handler, call with wb->lock held
+static int bindings_wb_flush (bindings_t *b, bindings_wb_t *wb) {
+  size_t done = 0;
+
+  while (done < wb->length) {
+    bindings_req_t *r = bindings_req_alloc(b);
+
+    r->op = OP_WRITE;
+    r->context_pid = wb->context_pid;
+    r->context_uid = wb->context_uid;
+    r->context_gid = wb->context_gid;
+    r->path = wb->path;
+    r->ino = wb->ino;
+    memset(&(r->own_info), 0, sizeof(struct fuse_file_info));
+    r->own_info.fh = wb->fh;
+    r->info = &(r->own_info);
+    r->data = (void *) (wb->data + done);
+    r->offset = wb->offset + done;
+    r->length = wb->length - done;
+
+    int result = bindings_call(r);
+    if (result <= 0) {
+      wb->error = result < 0 ? result : -EIO;
+      break;
+    }
+    done += result;
+  }
 
-  return bindings_call(b);
+  wb->length = 0;
+  return wb->error;
 }
 
-static int bindings_removexattr (const char *path, const char *name) {
-  bindings_t *b = bindings_get_context();
+// returns true if the write was buffered, result is then what to reply with
+static bool bindings_wb_write (bindings_req_t *r, int *result) {
+  bindings_t *b = r->b;
+  bindings_wb_t *wb;
+
+  mutex_lock(&(b->wb_lock));
+  wb = bindings_wb_find(b, r->path, r->ino, r->info->fh);
+
+  if (wb == NULL && r->length < b->write_buffer_size) {
+    wb = (bindings_wb_t *) calloc(1, sizeof(bindings_wb_t));
+    wb->path = r->path != NULL ? strdup(r->path) : NULL;
+    wb->ino = r->ino;
+    wb->fh = r->info->fh;
+    wb->data = (char *) malloc(b->write_buffer_size);
+    wb->refs = 2;
+    mutex_init(&(wb->lock));
+    wb->next = b->wb;
+    b->wb = wb;
+  }
+  mutex_unlock(&(b->wb_lock));
 
-  b->op = OP_REMOVEXATTR;
-  b->path = (char *) path;
-  b->name = (char *) name;
+  if (wb == NULL) return false;
 
-  return bindings_call(b);
-}
+  mutex_lock(&(wb->lock));
 
-static int bindings_statfs (const char *path, struct statvfs *statfs) {
-  bindings_t *b = bindings_get_context();
-  
-  b->op = OP_STATFS;
-  b->path = (char *) path;
-  b->data = statfs;
+  // large writes go straight through, after whatever was buffered before them
+  if (r->length >= b->write_buffer_size) {
+    if (wb->length > 0) bindings_wb_flush(b, wb);
+    mutex_unlock(&(wb->lock));
+    bindings_wb_put(b, wb);
+    return false;
+  }
+
+  *result = r->length;
+  if (wb->length > 0 && (r->offset != wb->offset + (FUSE_OFF_T) wb->length || wb->length + r->length > b->write_buffer_size)) {
+    int err = bindings_wb_flush(b, wb);
+    if (err < 0) {
+      *result = err;
+      mutex_unlock(&(wb->lock));
+      bindings_wb_put(b, wb);
+      return true;
+    }
+  }
+
+  uint64_t now = uv_hrtime();
+  if (wb->length == 0) {
+    wb->offset = r->offset;
+    wb->time = now;
+    wb->context_pid = r->context_pid;
+    wb->context_uid = r->context_uid;
+    wb->context_gid = r->context_gid;
+  }
+
+  memcpy(wb->data + wb->length, r->data, r->length);
+  wb->length += r->length;
 
-  return bindings_call(b);
+  if (wb->length == b->write_buffer_size || now - wb->time >= b->write_buffer_delay) {
+    int err = bindings_wb_flush(b, wb);
+    if (err < 0) *result = err;
+  }
+
+  mutex_unlock(&(wb->lock));
+  bindings_wb_put(b, wb);
+  return true;
 }
 
-static int bindings_open (const char *path, struct fuse_file_info *info) {
-  bindings_t *b = bindings_get_context();
+// flushes the buffers of a file, or the ones older than maxDelay if expired is set.
+// flushing calls into js, so the buffers are collected first and flushed without holding b->wb_lock
+static void bindings_wb_flush_each (bindings_t *b, const char *path, uint64_t ino, bool expired) {
+  bindings_wb_t *stack[16];
+  bindings_wb_t **found = stack;
+  uint32_t length = 0;
+  uint32_t alloc = 16;
+
+  mutex_lock(&(b->wb_lock));
+  for (bindings_wb_t *wb = b->wb; wb != NULL; wb = wb->next) {
+    if (expired ? wb->length == 0 : !bindings_wb_match(b, wb, path, ino)) continue;
+    if (length == alloc) {
+      alloc *= 2;
+      if (found == stack) found = (bindings_wb_t **) memcpy(malloc(alloc * sizeof(bindings_wb_t *)), stack, sizeof(stack));
+      else found = (bindings_wb_t **) realloc(found, alloc * sizeof(bindings_wb_t *));
+    }
+    wb->refs++;
+    found[length++] = wb;
+  }
+  mutex_unlock(&(b->wb_lock));
+
+  for (uint32_t i = 0; i < length; i++) {
+    bindings_wb_t *wb = found[i];
+    mutex_lock(&(wb->lock));
+    if (wb->length > 0 && (!expired || uv_hrtime() - wb->time >= b->write_buffer_delay)) bindings_wb_flush(b, wb);
+    mutex_unlock(&(wb->lock));
+    bindings_wb_put(b, wb);
+  }
 
-  b->op = OP_OPEN;
-  b->path = (char *) path;
-  b->mode = info->flags;
-  b->info = info;
+  if (found != stack) free(found);
+}
 
-  return bindings_call(b);
+// before anything that reads or changes the file, every open handle of it is flushed
+static void bindings_wb_flush_path (bindings_t *b, const char *path, uint64_t ino) {
+  bindings_wb_flush_each(b, path, ino, false);
 }
 
-static int bindings_opendir (const char *path, struct fuse_file_info *info) {
-  bindings_t *b = bindings_get_context();
+// without this a file that goes idle would keep its data, and hide write errors, until it is closed
+static thread_fn_rtn_t bindings_wb_thread (void *data) {
+  bindings_t *b = (bindings_t *) data;
+  uint64_t tick = b->write_buffer_delay / 2000000;
+  if (tick < 1) tick = 1;
+  if (tick > 100) tick = 100;
 
-  b->op = OP_OPENDIR;
-  b->path = (char *) path;
-  b->mode = info->flags;
-  b->info = info;
+  while (!atomic_get(&(b->wb_stop))) {
+    thread_sleep((uint32_t) tick);
+    bindings_wb_flush_each(b, NULL, 0, true);
+  }
 
-  return bindings_call(b);
+  return 0;
 }
 
-static int bindings_read (const char *path, char *buf, size_t len, FUSE_OFF_T offset, struct fuse_file_info *info) {
-  bindings_t *b = bindings_get_context();
+// flush and fsync, returns the deferred error of the handle if there is one
+static int bindings_wb_sync (bindings_t *b, const char *path, uint64_t ino, uint64_t fh) {
+  mutex_lock(&(b->wb_lock));
+  bindings_wb_t *wb = bindings_wb_find(b, path, ino, fh);
+  mutex_unlock(&(b->wb_lock));
 
-  b->op = OP_READ;
-  b->path = (char *) path;
-  b->data = (void *) buf;
-  b->offset = offset;
-  b->length = len;
-  b->info = info;
+  if (wb == NULL) return 0;
 
-  return bindings_call(b);
+  mutex_lock(&(wb->lock));
+  if (wb->length > 0) bindings_wb_flush(b, wb);
+  int err = wb->error;
+  wb->error = 0;
+  mutex_unlock(&(wb->lock));
+
+  bindings_wb_put(b, wb);
+  return err;
 }
 
-static int bindings_write (const char *path, const char *buf, size_t len, FUSE_OFF_T offset, struct fuse_file_info * info) {
-  bindings_t *b = bindings_get_context();
+static int bindings_wb_release (bindings_t *b, const char *path, uint64_t ino, uint64_t fh) {
+  bindings_wb_t *wb = NULL;
+
+  mutex_lock(&(b->wb_lock));
+  for (bindings_wb_t **prev = &(b->wb); *prev != NULL; prev = &((*prev)->next)) {
+    if ((*prev)->fh == fh && bindings_wb_match(b, *prev, path, ino)) {
+      wb = *prev;
+      *prev = wb->next;
+      break;
+    }
+  }
+  mutex_unlock(&(b->wb_lock));
 
-  b->op = OP_WRITE;
-  b->path = (char *) path;
-  b->data = (void *) buf;
-  b->offset = offset;
-  b->length = len;
-  b->info = info;
+  if (wb == NULL) return 0;
 
-  return bindings_call(b);
+  mutex_lock(&(wb->lock));
+  if (wb->length > 0) bindings_wb_flush(b, wb);
+  int err = wb->error;
+  mutex_unlock(&(wb->lock));
+
+  // a flush_path that picked it up before it left the list frees it instead
+  bindings_wb_put(b, wb);
+  return err;
 }
 
-static int bindings_release (const char *path, struct fuse_file_info *info) {
-  bindings_t *b = bindings_get_context();
+static int bindings_mknod (const char *path, mode_t mode, dev_t dev) {
+  bindings_req_t *r = bindings_get_context();
 
-  b->op = OP_RELEASE;
-  b->path = (char *) path;
-  b->info = info;
+  r->op = OP_MKNOD;
+  r->path = (char *) path;
+  r->mode = mode;
+  r->dev = dev;
 
-  return bindings_call(b);
+  return bindings_call(r);
 }
 
-static int bindings_releasedir (const char *path, struct fuse_file_info *info) {
-  bindings_t *b = bindings_get_context();
+static int bindings_truncate (const char *path, FUSE_OFF_T size) {
+  bindings_req_t *r = bindings_get_context();
+  if (r->b->write_buffer_size > 0) bindings_wb_flush_path(r->b, path, 0);
 
-  b->op = OP_RELEASEDIR;
-  b->path = (char *) path;
-  b->info = info;
+  r->op = OP_TRUNCATE;
+  r->path = (char *) path;
+  r->length = size;
 
-  return bindings_call(b);
+  return bindings_call(r);
 }
 
-static int bindings_access (const char *path, int mode) {
-  bindings_t *b = bindings_get_context();
+static int bindings_ftruncate (const char *path, FUSE_OFF_T size, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_get_context();
+  if (r->b->write_buffer_size > 0) bindings_wb_flush_path(r->b, path, 0);
 
-  b->op = OP_ACCESS;
-  b->path = (char *) path;
-  b->mode = mode;
+  r->op = OP_FTRUNCATE;
+  r->path = (char *) path;
+  r->length = size;
+  r->info = info;
 
-  return bindings_call(b);
+  return bindings_call(r);
 }
 
-static int bindings_create (const char *path, mode_t mode, struct fuse_file_info *info) {
-  bindings_t *b = bindings_get_context();
+NAN_INLINE static int bindings_attr_cache_get (bindings_t *b, const void *key, size_t key_length, struct FUSE_STAT *stat) {
+  size_t size = sizeof(struct FUSE_STAT);
+  return cache_get(b->attr_cache, key, key_length, stat, &size);
+}
+
+// an answer from before a mutation finished must not be cached after it was invalidated.
+// checked again after the put, as the invalidation can run in between
+static void bindings_attr_cache_put_since (bindings_t *b, cache_t *cache, uint32_t gen, const void *key, size_t key_length, const void *value, size_t value_size, uint64_t expires) {
+  if (atomic_get(&(b->attr_gen)) != gen) return;
+  cache_put(cache, key, key_length, value, value_size, expires);
+  if (atomic_get(&(b->attr_gen)) != gen) cache_del(cache, key, key_length);
+}
 
-  b->op = OP_CREATE;
-  b->path = (char *) path;
-  b->mode = mode;
-  b->info = info;
+static int bindings_negative (bindings_t *b, const char *path) {
+  if (matcher_match(b->negative_rules, path)) return 1;
+  if (b->negative_cache == NULL) return 0;
 
-  return bindings_call(b);
+  char value;
+  size_t size = 0;
+  return cache_get(b->negative_cache, path, strlen(path), &value, &size);
 }
 
-static int bindings_utimens (const char *path, const struct timespec tv[2]) {
-  bindings_t *b = bindings_get_context();
+static int bindings_getattr (const char *path, struct FUSE_STAT *stat) {
+  bindings_t *b = (bindings_t *) fuse_get_context()->private_data;
+  if (bindings_negative(b, path)) return -ENOENT;
+  if (b->write_buffer_size > 0) bindings_wb_flush_path(b, path, 0);
+  if (b->attr_cache != NULL && bindings_attr_cache_get(b, path, strlen(path), stat)) return 0;
+
+  bindings_req_t *r = bindings_get_context();
 
-  b->op = OP_UTIMENS;
-  b->path = (char *) path;
-  b->data = (void *) tv;
+  r->op = OP_GETATTR;
+  r->path = (char *) path;
+  r->data = stat;
 
-  return bindings_call(b);
+  int result = bindings_call(r);
+
+  if (result == -ENOENT && b->negative_cache != NULL) {
+    bindings_attr_cache_put_since(b, b->negative_cache, r->attr_gen, path, strlen(path), NULL, 0, uv_hrtime() + (uint64_t) (b->negative_cache_ttl * 1e9));
+  }
+
+  return result;
 }
 
-static int bindings_unlink (const char *path) {
-  bindings_t *b = bindings_get_context();
+static int bindings_fgetattr (const char *path, struct FUSE_STAT *stat, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_get_context();
+  if (r->b->write_buffer_size > 0) bindings_wb_flush_path(r->b, path, 0);
 
-  b->op = OP_UNLINK;
-  b->path = (char *) path;
+  r->op = OP_FGETATTR;
+  r->path = (char *) path;
+  r->data = stat;
+  r->info = info;
 
-  return bindings_call(b);
+  return bindings_call(r);
 }
 
-static int bindings_rename (const char *src, const char *dest) {
-  bindings_t *b = bindings_get_context();
+static int bindings_flush (const char *path, struct fuse_file_info *info) {
+  bindings_t *b = (bindings_t *) fuse_get_context()->private_data;
+  int err = b->write_buffer_size > 0 ? bindings_wb_sync(b, path, 0, info->fh) : 0;
+  if (b->ops_flush == NULL) return err;
 
-  b->op = OP_RENAME;
-  b->path = (char *) src;
-  b->data = (void *) dest;
+  bindings_req_t *r = bindings_get_context();
 
-  return bindings_call(b);
+  r->op = OP_FLUSH;
+  r->path = (char *) path;
+  r->info = info;
+
+  if (b->deferred_flush && bindings_defer(r)) return err;
+  int result = bindings_call(r);
+  return err < 0 ? err : result;
 }
 
-static int bindings_link (const char *path, const char *dest) {
-  bindings_t *b = bindings_get_context();
+static int bindings_fsync (const char *path, int datasync, struct fuse_file_info *info) {
+  bindings_t *b = (bindings_t *) fuse_get_context()->private_data;
+  int err = b->write_buffer_size > 0 ? bindings_wb_sync(b, path, 0, info->fh) : 0;
+  if (b->ops_fsync == NULL) return err;
+
+  bindings_req_t *r = bindings_get_context();
 
-  b->op = OP_LINK;
-  b->path = (char *) path;
-  b->data = (void *) dest;
+  r->op = OP_FSYNC;
+  r->path = (char *) path;
+  r->mode = datasync;
+  r->info = info;
 
-  return bindings_call(b);
+  int result = bindings_call(r);
+  return err < 0 ? err : result;
 }
 
-static int bindings_symlink (const char *path, const char *dest) {
-  bindings_t *b = bindings_get_context();
+static int bindings_fsyncdir (const char *path, int datasync, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_get_context();
 
-  b->op = OP_SYMLINK;
-  b->path = (char *) path;
-  b->data = (void *) dest;
+  r->op = OP_FSYNCDIR;
+  r->path = (char *) path;
+  r->mode = datasync;
+  r->info = info;
 
-  return bindings_call(b);
+  return bindings_call(r);
 }
 
-static int bindings_mkdir (const char *path, mode_t mode) {
-  bindings_t *b = bindings_get_context();
+static void bindings_readdir_cache (bindings_t *b, uint32_t gen, const char *path, const char *name, struct FUSE_STAT *stat) {
+  if (!strcmp(name, ".") || !strcmp(name, "..")) return;
+
+  char key[4096];
+  size_t path_len = strlen(path);
+  size_t name_len = strlen(name);
+  if (path_len + name_len + 2 > sizeof(key)) return;
 
-  b->op = OP_MKDIR;
-  b->path = (char *) path;
-  b->mode = mode;
+  memcpy(key, path, path_len);
+  if (path_len > 1) key[path_len++] = '/';
+  memcpy(key + path_len, name, name_len);
 
-  return bindings_call(b);
+  uint64_t expires = uv_hrtime() + (uint64_t) (b->attr_cache_ttl * 1e9);
+  bindings_attr_cache_put_since(b, b->attr_cache, gen, key, path_len + name_len, stat, sizeof(struct FUSE_STAT), expires);
 }
 
-static int bindings_rmdir (const char *path) {
-  bindings_t *b = bindings_get_context();
+static int bindings_readdir (const char *path, void *buf, fuse_fill_dir_t filler, FUSE_OFF_T offset, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_get_context();
+  bindings_t *b = r->b;
+  bindings_dir_t dir;
+
+  memset(&dir, 0, sizeof(dir));
+  r->op = OP_READDIR;
+  r->path = (char *) path;
+  r->offset = offset;
+  r->data = &dir;
+  r->info = info;
+
+  int result = bindings_call(r);
+  char *name = dir.names;
+
+  // paginated handlers number their entries so fuse can resume after a full buffer
+  for (uint32_t i = 0; result == 0 && i < dir.length; i++) {
+    struct FUSE_STAT *stat = dir.stats == NULL ? NULL : dir.stats + i;
+    if (filler(buf, name, stat, b->readdir_offset ? offset + i + 1 : 0)) break;
+    if (stat != NULL && path != NULL && b->attr_cache != NULL && b->attr_cache_ttl > 0) bindings_readdir_cache(b, r->attr_gen, path, name, stat);
+    name += strlen(name) + 1;
+  }
+
+  free(dir.names);
+  free(dir.stats);
+  return result;
+}
+
+static int bindings_readlink (const char *path, char *buf, size_t len) {
+  bindings_req_t *r = bindings_get_context();
 
-  b->op = OP_RMDIR;
-  b->path = (char *) path;
+  r->op = OP_READLINK;
+  r->path = (char *) path;
+  r->data = (void *) buf;
+  r->length = len;
 
-  return bindings_call(b);
+  return bindings_call(r);
 }
 
-static void* bindings_init (struct fuse_conn_info *conn) {
-  bindings_t *b = bindings_get_context();
+static int bindings_chown (const char *path, uid_t uid, gid_t gid) {
+  bindings_req_t *r = bindings_get_context();
 
-  b->op = OP_INIT;
+  r->op = OP_CHOWN;
+  r->path = (char *) path;
+  r->uid = uid;
+  r->gid = gid;
 
-  bindings_call(b);
-  return b;
+  return bindings_call(r);
 }
 
-static void bindings_destroy (void *data) {
-  bindings_t *b = bindings_get_context();
+static int bindings_chmod (const char *path, mode_t mode) {
+  bindings_req_t *r = bindings_get_context();
 
-  b->op = OP_DESTROY;
+  r->op = OP_CHMOD;
+  r->path = (char *) path;
+  r->mode = mode;
 
-  bindings_call(b);
+  return bindings_call(r);
 }
 
-static void bindings_free (bindings_t *b) {
-  if (b->ops_access != NULL) delete b->ops_access;
-  if (b->ops_truncate != NULL) delete b->ops_truncate;
+// exact names win over prefixes, longer prefixes over shorter ones
+static bindings_xattr_rule_t *bindings_xattr_rule (bindings_t *b, const char *name) {
+  bindings_xattr_rule_t *match = NULL;
+
+  for (uint32_t i = 0; i < b->xattr_rules_length; i++) {
+    bindings_xattr_rule_t *rule = b->xattr_rules + i;
+    if (!rule->prefix) {
+      if (!strcmp(rule->name, name)) return rule;
+    } else if ((match == NULL || rule->length > match->length) && !strncmp(rule->name, name, rule->length)) {
+      match = rule;
+    }
+  }
+
+  return match;
+}
+
+// answers a get or list from a known value the way the kernel expects, a size of 0 only asks for the length
+static int bindings_xattr_reply (const char *data, size_t length, char *value, size_t size) {
+  if (size == 0) return (int) length;
+  if (length > size) return -ERANGE;
+  memcpy(value, data, length);
+  return (int) length;
+}
+
+static char *bindings_xattr_key (const char *path, const char *name, size_t *key_length) {
+  size_t path_length = strlen(path);
+  size_t name_length = name != NULL ? strlen(name) : 0;
+  char *key = (char *) malloc(path_length + name_length + 1);
+
+  memcpy(key, path, path_length);
+  key[path_length] = '\0';
+  if (name_length) memcpy(key + path_length + 1, name, name_length);
+  *key_length = path_length + name_length + 1;
+  return key;
+}
+
+// returns 1 and sets *result if the cache could answer
+// the value is copied straight into the caller's buffer, a value that does not fit is an ERANGE anyway
+static int bindings_xattr_cache_get (bindings_t *b, const char *key, size_t key_length, char *value, size_t size, int *result) {
+  bindings_xattr_entry_t entry;
+  size_t length = size;
+
+  if (!cache_get_split(b->xattr_cache, key, key_length, &entry, sizeof(entry), value, &length)) return 0;
+
+  if (entry.result < 0 || size == 0) *result = entry.result;
+  else if (!entry.has_value) return 0;
+  else *result = length > size ? -ERANGE : (int) length;
+
+  return 1;
+}
+
+static void bindings_xattr_cache_put (bindings_t *b, const char *key, size_t key_length, const char *value, size_t size, int result) {
+  if (b->xattr_cache_ttl <= 0) return;
+  // only missing attributes are remembered, other errors are retried
+  if (result < 0 && result != -BINDINGS_ENOATTR && result != -ENOTSUP) return;
+
+  size_t value_length = result > 0 && size > 0 ? result : 0;
+  bindings_xattr_entry_t *entry = (bindings_xattr_entry_t *) malloc(sizeof(bindings_xattr_entry_t) + value_length);
+  entry->result = result;
+  entry->has_value = size > 0 || result <= 0;
+  if (value_length) memcpy(entry + 1, value, value_length);
+
+  uint64_t expires = uv_hrtime() + (uint64_t) (b->xattr_cache_ttl * 1e9);
+  cache_put(b->xattr_cache, key, key_length, entry, sizeof(bindings_xattr_entry_t) + value_length, expires);
+  free(entry);
+}
+
+static void bindings_xattr_cache_del (cache_t *cache, const char *path, bool subtree) {
+  if (path == NULL) return;
+
+  size_t length = strlen(path);
+  char *prefix = (char *) malloc(length + 2);
+  memcpy(prefix, path, length);
+  prefix[length] = '\0';
+  cache_del_prefix(cache, prefix, length + 1);
+
+  if (subtree) {
+    prefix[length] = '/';
+    cache_del_prefix(cache, prefix, length + 1);
+  }
+
+  free(prefix);
+}
+
+static int bindings_getxattr_call (const char *path, const char *name, char *value, size_t size, uint32_t position) {
+  bindings_t *b = (bindings_t *) fuse_get_context()->private_data;
+  bindings_xattr_rule_t *rule = position == 0 ? bindings_xattr_rule(b, name) : NULL;
+
+  if (rule != NULL && !rule->pass) {
+    return rule->value != NULL ? bindings_xattr_reply(rule->value, rule->value_length, value, size) : rule->result;
+  }
+
+  // the policy is what made the op reachable when there is no handler
+  if (b->ops_getxattr == NULL) return -BINDINGS_ENOATTR;
+
+  size_t key_length = 0;
+  char *key = NULL;
+  int result;
+
+  if (b->xattr_cache != NULL && position == 0) {
+    key = bindings_xattr_key(path, name, &key_length);
+    if (bindings_xattr_cache_get(b, key, key_length, value, size, &result)) {
+      free(key);
+      return result;
+    }
+  }
+
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_GETXATTR;
+  r->path = (char *) path;
+  r->name = (char *) name;
+  r->data = (void *) value;
+  r->length = size;
+  r->offset = position;
+
+  result = bindings_call(r);
+
+  if (key != NULL) {
+    bindings_xattr_cache_put(b, key, key_length, value, size, result);
+    free(key);
+  }
+
+  return result;
+}
+
+#ifdef __APPLE__
+static int bindings_setxattr (const char *path, const char *name, const char *value, size_t size, int flags, uint32_t position) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_SETXATTR;
+  r->path = (char *) path;
+  r->name = (char *) name;
+  r->data = (void *) value;
+  r->length = size;
+  r->offset = position;
+  r->mode = flags;
+
+  return bindings_call(r);
+}
+
+static int bindings_getxattr (const char *path, const char *name, char *value, size_t size, uint32_t position) {
+  return bindings_getxattr_call(path, name, value, size, position);
+}
+#else
+static int bindings_setxattr (const char *path, const char *name, const char *value, size_t size, int flags) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_SETXATTR;
+  r->path = (char *) path;
+  r->name = (char *) name;
+  r->data = (void *) value;
+  r->length = size;
+  r->offset = 0;
+  r->mode = flags;
+
+  return bindings_call(r);
+}
+
+static int bindings_getxattr (const char *path, const char *name, char *value, size_t size) {
+  return bindings_getxattr_call(path, name, value, size, 0);
+}
+#endif
+
+static int bindings_listxattr (const char *path, char *list, size_t size) {
+  bindings_t *b = (bindings_t *) fuse_get_context()->private_data;
+  size_t key_length = 0;
+  char *key = NULL;
+  int result;
+
+  if (b->xattr_cache != NULL) {
+    key = bindings_xattr_key(path, NULL, &key_length);
+    if (bindings_xattr_cache_get(b, key, key_length, list, size, &result)) {
+      free(key);
+      return result;
+    }
+  }
+
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_LISTXATTR;
+  r->path = (char *) path;
+  r->data = (void *) list;
+  r->length = size;
+
+  result = bindings_call(r);
+
+  if (key != NULL) {
+    bindings_xattr_cache_put(b, key, key_length, list, size, result);
+    free(key);
+  }
+
+  return result;
+}
+
+static int bindings_removexattr (const char *path, const char *name) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_REMOVEXATTR;
+  r->path = (char *) path;
+  r->name = (char *) name;
+
+  return bindings_call(r);
+}
+
+static int bindings_statfs (const char *path, struct statvfs *statfs) {
+  bindings_req_t *r = bindings_get_context();
+  
+  r->op = OP_STATFS;
+  r->path = (char *) path;
+  r->data = statfs;
+
+  return bindings_call(r);
+}
+
+static int bindings_open (const char *path, struct fuse_file_info *info) {
+  if (bindings_negative((bindings_t *) fuse_get_context()->private_data, path)) return -ENOENT;
+
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_OPEN;
+  r->path = (char *) path;
+  r->mode = info->flags;
+  r->info = info;
+
+  return bindings_call(r);
+}
+
+static int bindings_opendir (const char *path, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_OPENDIR;
+  r->path = (char *) path;
+  r->mode = info->flags;
+  r->info = info;
+
+  return bindings_call(r);
+}
+
+struct bindings_rc_state_t {
+  uint64_t next; // where a sequential reader continues
+  uint64_t ahead; // first block that has not been prefetched
+  uint32_t window; // blocks to stay ahead, doubles while reads stay sequential
+};
+
+// the key has room for a block number after *length
+static char *bindings_rc_key (bindings_t *b, const char *path, uint64_t ino, uint64_t fh, size_t *length) {
+  if (path == NULL) path = ""; // ops.nullPath, blocks are only told apart by fh
+  size_t len = b->lowlevel ? sizeof(ino) : strlen(path) + 1;
+  char *key = (char *) malloc(len + 2 * sizeof(uint64_t));
+
+  if (b->lowlevel) memcpy(key, &ino, len);
+  else memcpy(key, path, len);
+  memcpy(key + len, &fh, sizeof(fh));
+
+  *length = len + sizeof(fh);
+  return key;
+}
+
+static void bindings_rc_prefetch_done (bindings_req_t *r) {
+  bindings_t *b = r->b;
+  size_t key_length;
+  char *key = bindings_rc_key(b, r->path, r->ino, r->info->fh, &key_length);
+  struct bindings_rc_state_t state;
+  size_t size = sizeof(state);
+
+  // the file might have been released while this was in flight
+  if (r->result >= 0 && cache_get(b->read_state, key, key_length, &state, &size)) {
+    uint64_t block = r->offset / b->read_block_size;
+    size_t length = r->result < r->length ? r->result : r->length;
+    memcpy(key + key_length, &block, sizeof(block));
+    cache_put(b->read_cache, key, key_length + sizeof(block), r->data, length, 0);
+  }
+
+  free(key);
+  free(r->data);
+  free(r->path);
+  r->path = NULL;
+
+  atomic_add(&(b->prefetching), -1);
+  bindings_req_free(r);
+}
+
+static void bindings_rc_prefetch (bindings_req_t *src, uint64_t block) {
+  bindings_t *b = src->b;
+  bindings_req_t *r = bindings_req_alloc(b);
+
+  r->op = OP_READ;
+  r->context_pid = src->context_pid;
+  r->context_uid = src->context_uid;
+  r->context_gid = src->context_gid;
+  r->path = src->path != NULL ? strdup(src->path) : NULL;
+  r->ino = src->ino;
+  memset(&(r->own_info), 0, sizeof(struct fuse_file_info));
+  r->own_info.fh = src->info->fh;
+  r->info = &(r->own_info);
+  r->offset = block * b->read_block_size;
+  r->length = b->read_block_size;
+  r->data = malloc(b->read_block_size);
+
+  atomic_add(&(b->prefetching), 1);
+  atomic_add64(&(b->prefetches), 1);
+  bindings_call_async(r, bindings_rc_prefetch_done);
+}
+
+// serves r from cached blocks if they are all there and keeps prefetching ahead of sequential readers
+// returns -1 when the read has to go to js
+static int bindings_rc_read (bindings_req_t *r, char *buf) {
+  bindings_t *b = r->b;
+  uint64_t bs = b->read_block_size;
+  uint64_t offset = r->offset;
+  uint64_t end = offset + r->length;
+  size_t key_length;
+  char *key = bindings_rc_key(b, r->path, r->ino, r->info->fh, &key_length);
+
+  struct bindings_rc_state_t state = {0, 0, 0};
+  size_t size = sizeof(state);
+
+  // readers of the same handle can run in parallel, so the state is only changed under rc_lock
+  mutex_lock(&(b->rc_lock));
+  cache_get(b->read_state, key, key_length, &state, &size);
+
+  if (offset == state.next) {
+    state.window = state.window ? 2 * state.window : 1;
+    if (state.window > b->read_ahead) state.window = b->read_ahead;
+  } else {
+    state.window = 0;
+    state.ahead = 0;
+  }
+  state.next = end;
+
+  cache_put(b->read_state, key, key_length, &state, sizeof(state), 0);
+  mutex_unlock(&(b->rc_lock));
+
+  int result = 0;
+  bool eof = false;
+  char *block = (char *) malloc(bs);
+
+  for (uint64_t i = offset / bs; i * bs < end; i++) {
+    memcpy(key + key_length, &i, sizeof(i));
+    size = bs;
+    if (!cache_get(b->read_cache, key, key_length + sizeof(i), block, &size)) {
+      result = -1;
+      break;
+    }
+
+    uint64_t from = (offset > i * bs ? offset : i * bs) - i * bs;
+    uint64_t to = (end < i * bs + size ? end : i * bs + size) - i * bs;
+    if (to > from) {
+      memcpy(buf + result, block + from, to - from);
+      result += to - from;
+    }
+
+    if (size < bs) {
+      eof = true;
+      break;
+    }
+  }
+
+  free(block);
+
+  if (state.window > 0 && !eof) {
+    mutex_lock(&(b->rc_lock));
+
+    // another reader might have moved ahead meanwhile, and a released handle has no state left
+    size = sizeof(state);
+    if (cache_get(b->read_state, key, key_length, &state, &size)) {
+      uint64_t next = (end + bs - 1) / bs;
+      uint64_t until = next + state.window;
+      for (uint64_t i = (state.ahead > next ? state.ahead : next); i < until; i++) bindings_rc_prefetch(r, i);
+      if (until > state.ahead) state.ahead = until;
+      cache_put(b->read_state, key, key_length, &state, sizeof(state), 0);
+    }
+
+    mutex_unlock(&(b->rc_lock));
+  }
+
+  free(key);
+  return result;
+}
+
+static void bindings_rc_release (bindings_t *b, const char *path, uint64_t ino, uint64_t fh) {
+  size_t key_length;
+  char *key = bindings_rc_key(b, path, ino, fh, &key_length);
+
+  cache_del(b->read_state, key, key_length);
+  cache_del_prefix(b->read_cache, key, key_length);
+  free(key);
+}
+
+static void bindings_rc_del_file (bindings_t *b, const char *path, uint64_t ino) {
+  size_t key_length;
+  char *key = bindings_rc_key(b, b->null_path ? NULL : path, ino, 0, &key_length);
+  cache_del_prefix(b->read_cache, key, key_length - sizeof(uint64_t));
+  free(key);
+}
+
+// writes drop the blocks of every open handle of the file
+static void bindings_rc_invalidate (bindings_req_t *r) {
+  bindings_t *b = r->b;
+
+  switch (r->op) {
+    case OP_WRITE:
+    case OP_TRUNCATE:
+    case OP_FTRUNCATE:
+    bindings_rc_del_file(b, r->path, r->ino);
+    break;
+
+    // in lowlevel mode ino is the parent directory and the inode of the entry is not known here
+    case OP_UNLINK:
+    case OP_RENAME:
+    if (b->lowlevel) {
+      cache_clear(b->read_cache);
+      break;
+    }
+    bindings_rc_del_file(b, r->path, 0);
+    if (r->op == OP_RENAME) bindings_rc_del_file(b, (char *) r->data, 0); // the file it replaced
+    break;
+
+    default:
+    break;
+  }
+}
+
+static int bindings_read (const char *path, char *buf, size_t len, FUSE_OFF_T offset, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_READ;
+  r->path = (char *) path;
+  r->data = (void *) buf;
+  r->offset = offset;
+  r->length = len;
+  r->info = info;
+
+  if (r->b->write_buffer_size > 0) bindings_wb_flush_path(r->b, path, 0);
+  if (r->b->read_cache != NULL) {
+    int result = bindings_rc_read(r, buf);
+    if (result > -1) {
+      bindings_req_free(r);
+      return result;
+    }
+  }
+
+  return bindings_call(r);
+}
+
+static int bindings_write (const char *path, const char *buf, size_t len, FUSE_OFF_T offset, struct fuse_file_info * info) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_WRITE;
+  r->path = (char *) path;
+  r->data = (void *) buf;
+  r->offset = offset;
+  r->length = len;
+  r->info = info;
+
+  int result;
+  if (r->b->write_buffer_size > 0 && bindings_wb_write(r, &result)) {
+    bindings_req_free(r);
+    return result;
+  }
+
+  return bindings_call(r);
+}
+
+#ifndef _WIN32
+static int bindings_read_buf (const char *path, struct fuse_bufvec **bufp, size_t len, FUSE_OFF_T offset, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_get_context();
+  bindings_read_fd_t read_fd = {-1, offset};
+  char *buf = (char *) malloc(len);
+
+  if (r->b->write_buffer_size > 0) bindings_wb_flush_path(r->b, path, 0);
+
+  r->op = OP_READ;
+  r->path = (char *) path;
+  r->data = (void *) buf;
+  r->read_fd = &read_fd;
+  r->offset = offset;
+  r->length = len;
+  r->info = info;
+
+  int result = bindings_call(r);
+  if (result < 0) {
+    free(buf);
+    return result;
+  }
+
+  // libfuse frees both the bufvec and the memory it points to
+  struct fuse_bufvec *bufv = (struct fuse_bufvec *) malloc(sizeof(struct fuse_bufvec));
+  *bufv = FUSE_BUFVEC_INIT((size_t) result);
+
+  if (read_fd.fd > -1) {
+    free(buf);
+    bufv->buf[0].flags = (enum fuse_buf_flags) (FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+    bufv->buf[0].fd = read_fd.fd;
+    bufv->buf[0].pos = read_fd.position;
+  } else {
+    bufv->buf[0].mem = buf;
+  }
+
+  *bufp = bufv;
+  return 0;
+}
+
+static int bindings_write_buf (const char *path, struct fuse_bufvec *src, FUSE_OFF_T offset, struct fuse_file_info *info) {
+  size_t len = fuse_buf_size(src);
+
+  // a single memory buffer can be handed to js as is
+  if (src->count == 1 && !(src->buf[0].flags & FUSE_BUF_IS_FD)) {
+    return bindings_write(path, (const char *) src->buf[0].mem, len, offset, info);
+  }
+
+  struct fuse_bufvec dst = FUSE_BUFVEC_INIT(len);
+  dst.buf[0].mem = malloc(len);
+
+  ssize_t copied = fuse_buf_copy(&dst, src, (enum fuse_buf_copy_flags) 0);
+  int result = copied < 0 ? copied : bindings_write(path, (const char *) dst.buf[0].mem, copied, offset, info);
+
+  free(dst.buf[0].mem);
+  return result;
+}
+#endif
+
+static int bindings_release (const char *path, struct fuse_file_info *info) {
+  bindings_t *b = (bindings_t *) fuse_get_context()->private_data;
+  int err = b->write_buffer_size > 0 ? bindings_wb_release(b, path, 0, info->fh) : 0;
+  if (b->read_cache != NULL) bindings_rc_release(b, path, 0, info->fh);
+  if (b->ops_release == NULL && !(info->fh & BINDINGS_FH_SLOT)) return err;
+
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_RELEASE;
+  r->path = (char *) path;
+  r->info = info;
+
+  if (bindings_defer(r)) return err;
+  int result = bindings_call(r);
+  return err < 0 ? err : result;
+}
+
+static int bindings_releasedir (const char *path, struct fuse_file_info *info) {
+  bindings_t *b = (bindings_t *) fuse_get_context()->private_data;
+  if (b->ops_releasedir == NULL && !(info->fh & BINDINGS_FH_SLOT)) return 0;
+
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_RELEASEDIR;
+  r->path = (char *) path;
+  r->info = info;
+
+  if (bindings_defer(r)) return 0;
+  return bindings_call(r);
+}
+
+static int bindings_access (const char *path, int mode) {
+  if (bindings_negative((bindings_t *) fuse_get_context()->private_data, path)) return -ENOENT;
+
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_ACCESS;
+  r->path = (char *) path;
+  r->mode = mode;
+
+  return bindings_call(r);
+}
+
+static int bindings_create (const char *path, mode_t mode, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_CREATE;
+  r->path = (char *) path;
+  r->mode = mode;
+  r->info = info;
+
+  return bindings_call(r);
+}
+
+static int bindings_utimens (const char *path, const struct timespec tv[2]) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_UTIMENS;
+  r->path = (char *) path;
+  r->data = (void *) tv;
+
+  return bindings_call(r);
+}
+
+static int bindings_unlink (const char *path) {
+  bindings_req_t *r = bindings_get_context();
+  if (r->b->write_buffer_size > 0) bindings_wb_flush_path(r->b, path, 0);
+
+  r->op = OP_UNLINK;
+  r->path = (char *) path;
+
+  return bindings_call(r);
+}
+
+static int bindings_rename (const char *src, const char *dest) {
+  bindings_req_t *r = bindings_get_context();
+  if (r->b->write_buffer_size > 0) bindings_wb_flush_path(r->b, src, 0);
+
+  r->op = OP_RENAME;
+  r->path = (char *) src;
+  r->data = (void *) dest;
+
+  return bindings_call(r);
+}
+
+static int bindings_link (const char *path, const char *dest) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_LINK;
+  r->path = (char *) path;
+  r->data = (void *) dest;
+
+  return bindings_call(r);
+}
+
+static int bindings_symlink (const char *path, const char *dest) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_SYMLINK;
+  r->path = (char *) path;
+  r->data = (void *) dest;
+
+  return bindings_call(r);
+}
+
+static int bindings_mkdir (const char *path, mode_t mode) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_MKDIR;
+  r->path = (char *) path;
+  r->mode = mode;
+
+  return bindings_call(r);
+}
+
+static int bindings_rmdir (const char *path) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_RMDIR;
+  r->path = (char *) path;
+
+  return bindings_call(r);
+}
+
+// the capabilities that can be asked for from js, not every fuse implementation has all of them
+static const struct {
+  const char *name;
+  uint32_t flag;
+} bindings_caps[] = {
+#ifdef FUSE_CAP_ASYNC_READ
+  {"asyncRead", FUSE_CAP_ASYNC_READ},
+#endif
+#ifdef FUSE_CAP_POSIX_LOCKS
+  {"posixLocks", FUSE_CAP_POSIX_LOCKS},
+#endif
+#ifdef FUSE_CAP_ATOMIC_O_TRUNC
+  {"atomicOTrunc", FUSE_CAP_ATOMIC_O_TRUNC},
+#endif
+#ifdef FUSE_CAP_EXPORT_SUPPORT
+  {"exportSupport", FUSE_CAP_EXPORT_SUPPORT},
+#endif
+#ifdef FUSE_CAP_BIG_WRITES
+  {"bigWrites", FUSE_CAP_BIG_WRITES},
+#endif
+#ifdef FUSE_CAP_DONT_MASK
+  {"dontMask", FUSE_CAP_DONT_MASK},
+#endif
+#ifdef FUSE_CAP_SPLICE_WRITE
+  {"spliceWrite", FUSE_CAP_SPLICE_WRITE},
+#endif
+#ifdef FUSE_CAP_SPLICE_MOVE
+  {"spliceMove", FUSE_CAP_SPLICE_MOVE},
+#endif
+#ifdef FUSE_CAP_SPLICE_READ
+  {"spliceRead", FUSE_CAP_SPLICE_READ},
+#endif
+#ifdef FUSE_CAP_FLOCK_LOCKS
+  {"flockLocks", FUSE_CAP_FLOCK_LOCKS},
+#endif
+  {NULL, 0}
+};
+
+// applied before ops.init runs so it sees what was actually negotiated
+static void bindings_conn_init (bindings_t *b, struct fuse_conn_info *conn) {
+  conn->want |= b->conn_want & conn->capable;
+  conn->want &= ~(b->conn_unwant);
+#ifdef FUSE_CAP_ASYNC_READ
+  if (b->conn_unwant & FUSE_CAP_ASYNC_READ) conn->async_read = 0;
+#endif
+
+  // both are already capped by the kernel and the channel buffer, they can only be lowered
+  if (b->max_write > 0 && b->max_write < conn->max_write) conn->max_write = b->max_write;
+  if (b->max_readahead > 0 && b->max_readahead < conn->max_readahead) conn->max_readahead = b->max_readahead;
+}
+
+static void* bindings_init (struct fuse_conn_info *conn) {
+  bindings_req_t *r = bindings_get_context();
+  bindings_t *b = r->b;
+
+  bindings_conn_init(b, conn);
+  r->op = OP_INIT;
+  r->data = (void *) conn;
+
+  bindings_call(r);
+  return b;
+}
+
+static void bindings_destroy (void *data) {
+  bindings_req_t *r = bindings_get_context();
+
+  r->op = OP_DESTROY;
+
+  bindings_call(r);
+}
+
+#ifndef _WIN32
+// lowlevel (inode based) engine, used when mounting with lowlevel: true
+
+static bindings_req_t *bindings_ll_context (fuse_req_t req) {
+  const struct fuse_ctx *ctx = fuse_req_ctx(req);
+  bindings_req_t *r = bindings_req_alloc((bindings_t *) fuse_req_userdata(req));
+  r->context_pid = ctx->pid;
+  r->context_uid = ctx->uid;
+  r->context_gid = ctx->gid;
+  return r;
+}
+
+static void bindings_ll_entry_init (bindings_t *b, struct fuse_entry_param *e) {
+  memset(e, 0, sizeof(struct fuse_entry_param));
+  e->attr_timeout = b->attr_timeout;
+  e->entry_timeout = b->entry_timeout;
+}
+
+static void bindings_ll_reply_entry (fuse_req_t req, int result, struct fuse_entry_param *e) {
+  if (result < 0) fuse_reply_err(req, -result);
+  else fuse_reply_entry(req, e);
+}
+
+// only a lookup can answer a miss with an entry, for the ops creating one it would be a bogus inode
+static void bindings_ll_reply_lookup (fuse_req_t req, bindings_t *b, int result, struct fuse_entry_param *e) {
+  if (result == -ENOENT && b->negative_timeout > 0) {
+    // ino 0 tells the kernel to cache the miss for entry_timeout
+    bindings_ll_entry_init(b, e);
+    e->entry_timeout = b->negative_timeout;
+    fuse_reply_entry(req, e);
+    return;
+  }
+
+  bindings_ll_reply_entry(req, result, e);
+}
+
+static void bindings_ll_init (void *userdata, struct fuse_conn_info *conn) {
+  bindings_req_t *r = bindings_req_alloc((bindings_t *) userdata);
+
+  bindings_conn_init(r->b, conn);
+  r->op = OP_INIT;
+  r->data = (void *) conn;
+
+  bindings_call(r);
+}
+
+static void bindings_ll_destroy (void *userdata) {
+  bindings_req_t *r = bindings_req_alloc((bindings_t *) userdata);
+
+  r->op = OP_DESTROY;
+
+  bindings_call(r);
+}
+
+static void bindings_ll_lookup (fuse_req_t req, fuse_ino_t parent, const char *name) {
+  bindings_t *b = (bindings_t *) fuse_req_userdata(req);
+  struct fuse_entry_param e;
+
+  // only the rules on the last component apply, there is no path to match the others against
+  if (matcher_match_name(b->negative_rules, name)) {
+    bindings_ll_reply_lookup(req, b, -ENOENT, &e);
+    return;
+  }
+
+  bindings_req_t *r = bindings_ll_context(req);
+  bindings_ll_entry_init(b, &e);
+
+  r->op = OP_LOOKUP;
+  r->ino = parent;
+  r->name = (char *) name;
+  r->data = &e;
+
+  bindings_ll_reply_lookup(req, b, bindings_call(r), &e);
+}
+
+static void bindings_ll_forget (fuse_req_t req, fuse_ino_t ino, unsigned long nlookup) {
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_FORGET;
+  r->ino = ino;
+  r->length = nlookup;
+
+  fuse_reply_none(req);
+  if (!bindings_defer(r)) bindings_call(r);
+}
+
+static void bindings_ll_getattr (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *info) {
+  bindings_t *b = (bindings_t *) fuse_req_userdata(req);
+  if (b->write_buffer_size > 0) bindings_wb_flush_path(b, NULL, ino);
+
+  if (b->attr_cache != NULL) {
+    uint64_t key = ino;
+    struct FUSE_STAT stat;
+    if (bindings_attr_cache_get(b, &key, sizeof(key), &stat)) {
+      fuse_reply_attr(req, &stat, b->attr_timeout);
+      return;
+    }
+  }
+
+  bindings_req_t *r = bindings_ll_context(req);
+  struct fuse_entry_param e;
+  bindings_ll_entry_init(r->b, &e);
+
+  r->op = OP_GETATTR;
+  r->ino = ino;
+  r->data = &e;
+
+  int result = bindings_call(r);
+  if (result < 0) fuse_reply_err(req, -result);
+  else fuse_reply_attr(req, &(e.attr), e.attr_timeout);
+}
+
+static void bindings_ll_readlink (fuse_req_t req, fuse_ino_t ino) {
+  bindings_req_t *r = bindings_ll_context(req);
+  char buf[4096];
+  buf[0] = '\0';
+
+  r->op = OP_READLINK;
+  r->ino = ino;
+  r->data = buf;
+  r->length = sizeof(buf);
+
+  int result = bindings_call(r);
+  if (result < 0) fuse_reply_err(req, -result);
+  else fuse_reply_readlink(req, buf);
+}
+
+static void bindings_ll_mknod (fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, dev_t dev) {
+  bindings_req_t *r = bindings_ll_context(req);
+  bindings_t *b = r->b;
+  struct fuse_entry_param e;
+  bindings_ll_entry_init(b, &e);
+
+  r->op = OP_MKNOD;
+  r->ino = parent;
+  r->name = (char *) name;
+  r->mode = mode;
+  r->dev = dev;
+  r->data = &e;
+
+  bindings_ll_reply_entry(req, bindings_call(r), &e);
+}
+
+static void bindings_ll_mkdir (fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode) {
+  bindings_req_t *r = bindings_ll_context(req);
+  bindings_t *b = r->b;
+  struct fuse_entry_param e;
+  bindings_ll_entry_init(b, &e);
+
+  r->op = OP_MKDIR;
+  r->ino = parent;
+  r->name = (char *) name;
+  r->mode = mode;
+  r->data = &e;
+
+  bindings_ll_reply_entry(req, bindings_call(r), &e);
+}
+
+static void bindings_ll_unlink (fuse_req_t req, fuse_ino_t parent, const char *name) {
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_UNLINK;
+  r->ino = parent;
+  r->name = (char *) name;
+
+  fuse_reply_err(req, -bindings_call(r));
+}
+
+static void bindings_ll_rmdir (fuse_req_t req, fuse_ino_t parent, const char *name) {
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_RMDIR;
+  r->ino = parent;
+  r->name = (char *) name;
+
+  fuse_reply_err(req, -bindings_call(r));
+}
+
+static void bindings_ll_open (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_OPEN;
+  r->ino = ino;
+  r->mode = info->flags;
+  r->info = info;
+
+  int result = bindings_call(r);
+  if (result < 0) fuse_reply_err(req, -result);
+  else fuse_reply_open(req, info);
+}
+
+static void bindings_ll_opendir (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_OPENDIR;
+  r->ino = ino;
+  r->mode = info->flags;
+  r->info = info;
+
+  int result = bindings_call(r);
+  if (result < 0) fuse_reply_err(req, -result);
+  else fuse_reply_open(req, info);
+}
+
+static void bindings_ll_create (fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_ll_context(req);
+  struct fuse_entry_param e;
+  bindings_ll_entry_init(r->b, &e);
+
+  r->op = OP_CREATE;
+  r->ino = parent;
+  r->name = (char *) name;
+  r->mode = mode;
+  r->info = info;
+  r->data = &e;
+
+  int result = bindings_call(r);
+  if (result < 0) fuse_reply_err(req, -result);
+  else fuse_reply_create(req, &e, info);
+}
+
+static void bindings_ll_read (fuse_req_t req, fuse_ino_t ino, size_t len, FUSE_OFF_T offset, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_ll_context(req);
+  char *buf = (char *) malloc(len);
+
+  r->op = OP_READ;
+  r->ino = ino;
+  r->data = (void *) buf;
+  r->offset = offset;
+  r->length = len;
+  r->info = info;
+
+  if (r->b->write_buffer_size > 0) bindings_wb_flush_path(r->b, NULL, ino);
+  int result = r->b->read_cache != NULL ? bindings_rc_read(r, buf) : -1;
+  if (result > -1) bindings_req_free(r);
+  else result = bindings_call(r);
+  if (result < 0) fuse_reply_err(req, -result);
+  else fuse_reply_buf(req, buf, result);
+
+  free(buf);
+}
+
+static void bindings_ll_write (fuse_req_t req, fuse_ino_t ino, const char *buf, size_t len, FUSE_OFF_T offset, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_WRITE;
+  r->ino = ino;
+  r->data = (void *) buf;
+  r->offset = offset;
+  r->length = len;
+  r->info = info;
+
+  int result;
+  if (r->b->write_buffer_size > 0 && bindings_wb_write(r, &result)) bindings_req_free(r);
+  else result = bindings_call(r);
+
+  if (result < 0) fuse_reply_err(req, -result);
+  else fuse_reply_write(req, result);
+}
+
+static void bindings_ll_flush (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *info) {
+  bindings_t *b = (bindings_t *) fuse_req_userdata(req);
+  int err = b->write_buffer_size > 0 ? bindings_wb_sync(b, NULL, ino, info->fh) : 0;
+  if (b->ops_flush == NULL) {
+    fuse_reply_err(req, -err);
+    return;
+  }
+
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_FLUSH;
+  r->ino = ino;
+  r->info = info;
+
+  if (b->deferred_flush && bindings_defer(r)) {
+    fuse_reply_err(req, -err);
+    return;
+  }
+
+  int result = bindings_call(r);
+  fuse_reply_err(req, -(err < 0 ? err : result));
+}
+
+static void bindings_ll_release (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *info) {
+  bindings_t *b = (bindings_t *) fuse_req_userdata(req);
+  int err = b->write_buffer_size > 0 ? bindings_wb_release(b, NULL, ino, info->fh) : 0;
+  if (b->read_cache != NULL) bindings_rc_release(b, NULL, ino, info->fh);
+  if (b->ops_release == NULL && !(info->fh & BINDINGS_FH_SLOT)) {
+    fuse_reply_err(req, -err);
+    return;
+  }
+
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_RELEASE;
+  r->ino = ino;
+  r->info = info;
+
+  if (bindings_defer(r)) {
+    fuse_reply_err(req, -err);
+    return;
+  }
+
+  int result = bindings_call(r);
+  fuse_reply_err(req, -(err < 0 ? err : result));
+}
+
+static void bindings_ll_releasedir (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *info) {
+  bindings_t *b = (bindings_t *) fuse_req_userdata(req);
+  if (b->ops_releasedir == NULL && !(info->fh & BINDINGS_FH_SLOT)) {
+    fuse_reply_err(req, 0);
+    return;
+  }
+
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_RELEASEDIR;
+  r->ino = ino;
+  r->info = info;
+
+  if (bindings_defer(r)) {
+    fuse_reply_err(req, 0);
+    return;
+  }
+
+  fuse_reply_err(req, -bindings_call(r));
+}
+
+static void bindings_ll_fsync (fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info *info) {
+  bindings_t *b = (bindings_t *) fuse_req_userdata(req);
+  int err = b->write_buffer_size > 0 ? bindings_wb_sync(b, NULL, ino, info->fh) : 0;
+  if (b->ops_fsync == NULL) {
+    fuse_reply_err(req, -err);
+    return;
+  }
+
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_FSYNC;
+  r->ino = ino;
+  r->mode = datasync;
+  r->info = info;
+
+  int result = bindings_call(r);
+  fuse_reply_err(req, -(err < 0 ? err : result));
+}
+
+static void bindings_ll_readdir (fuse_req_t req, fuse_ino_t ino, size_t len, FUSE_OFF_T offset, struct fuse_file_info *info) {
+  bindings_req_t *r = bindings_ll_context(req);
+  char *buf = (char *) malloc(len);
+
+  r->op = OP_READDIR;
+  r->ino = ino;
+  r->ll = req;
+  r->data = (void *) buf;
+  r->offset = offset;
+  r->length = len;
+  r->info = info;
+
+  // on success the result is the number of bytes packed into buf
+  int result = bindings_call(r);
+  if (result < 0) fuse_reply_err(req, -result);
+  else fuse_reply_buf(req, buf, result);
+
+  free(buf);
+}
+
+static void bindings_ll_statfs (fuse_req_t req, fuse_ino_t ino) {
+  bindings_req_t *r = bindings_ll_context(req);
+  struct statvfs statfs;
+  memset(&statfs, 0, sizeof(statfs));
+
+  r->op = OP_STATFS;
+  r->ino = ino;
+  r->data = &statfs;
+
+  int result = bindings_call(r);
+  if (result < 0) fuse_reply_err(req, -result);
+  else fuse_reply_statfs(req, &statfs);
+}
+
+static int bindings_ll_getattr_call (fuse_req_t req, fuse_ino_t ino, struct fuse_entry_param *e) {
+  bindings_req_t *r = bindings_ll_context(req);
+  bindings_ll_entry_init(r->b, e);
+
+  r->op = OP_GETATTR;
+  r->ino = ino;
+  r->data = e;
+
+  return bindings_call(r);
+}
+
+static int bindings_ll_setattr_call (fuse_req_t req, Nan::Callback *fn, bindings_req_t *tmpl) {
+  if (fn == NULL) return -ENOSYS;
+
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = tmpl->op;
+  r->ino = tmpl->ino;
+  r->mode = tmpl->mode;
+  r->uid = tmpl->uid;
+  r->gid = tmpl->gid;
+  r->length = tmpl->length;
+  r->data = tmpl->data;
+
+  return bindings_call(r);
+}
+
+static void bindings_ll_time (struct timespec *out, struct stat *attr, int to_set, int set, int now, bool mtime) {
+  if (to_set & now) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    out->tv_sec = tv.tv_sec;
+    out->tv_nsec = tv.tv_usec * 1000;
+    return;
+  }
+
+  if (!(to_set & set)) return; // filled from getattr by the caller
+#ifdef __APPLE__
+  *out = mtime ? attr->st_mtimespec : attr->st_atimespec;
+#else
+  *out = mtime ? attr->st_mtim : attr->st_atim;
+#endif
+}
+
+// there is no setattr handler, fuse's setattr runs the same chmod, chown, truncate and utimens handlers
+// the path based api would, one after the other, and replies with a fresh getattr
+static void bindings_ll_setattr (fuse_req_t req, fuse_ino_t ino, struct stat *attr, int to_set, struct fuse_file_info *info) {
+  bindings_t *b = (bindings_t *) fuse_req_userdata(req);
+  struct fuse_entry_param e;
+  bindings_req_t tmpl;
+  int result = 0;
+
+  if (b->write_buffer_size > 0) bindings_wb_flush_path(b, NULL, ino);
+
+  memset(&tmpl, 0, sizeof(tmpl));
+  tmpl.ino = ino;
+
+  if (to_set & FUSE_SET_ATTR_MODE) {
+    tmpl.op = OP_CHMOD;
+    tmpl.mode = attr->st_mode;
+    result = bindings_ll_setattr_call(req, b->ops_chmod, &tmpl);
+  }
+
+  if (result == 0 && (to_set & (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID))) {
+    tmpl.op = OP_CHOWN;
+    tmpl.uid = (to_set & FUSE_SET_ATTR_UID) ? (int) attr->st_uid : -1;
+    tmpl.gid = (to_set & FUSE_SET_ATTR_GID) ? (int) attr->st_gid : -1;
+    result = bindings_ll_setattr_call(req, b->ops_chown, &tmpl);
+  }
+
+  if (result == 0 && (to_set & FUSE_SET_ATTR_SIZE)) {
+    tmpl.op = OP_TRUNCATE;
+    tmpl.length = attr->st_size;
+    result = bindings_ll_setattr_call(req, b->ops_truncate, &tmpl);
+  }
+
+  int atime = FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_ATIME_NOW;
+  int mtime = FUSE_SET_ATTR_MTIME | FUSE_SET_ATTR_MTIME_NOW;
+
+  if (result == 0 && (to_set & (atime | mtime))) {
+    struct timespec tv[2];
+
+    // utimens always sets both, so the one that is not changing is read first
+    if (!(to_set & atime) || !(to_set & mtime)) {
+      result = bindings_ll_getattr_call(req, ino, &e);
+#ifdef __APPLE__
+      tv[0] = e.attr.st_atimespec;
+      tv[1] = e.attr.st_mtimespec;
+#else
+      tv[0] = e.attr.st_atim;
+      tv[1] = e.attr.st_mtim;
+#endif
+    }
+
+    if (result == 0) {
+      bindings_ll_time(tv, attr, to_set, FUSE_SET_ATTR_ATIME, FUSE_SET_ATTR_ATIME_NOW, false);
+      bindings_ll_time(tv + 1, attr, to_set, FUSE_SET_ATTR_MTIME, FUSE_SET_ATTR_MTIME_NOW, true);
+      tmpl.op = OP_UTIMENS;
+      tmpl.data = tv;
+      result = bindings_ll_setattr_call(req, b->ops_utimens, &tmpl);
+    }
+  }
+
+  if (result == 0) result = bindings_ll_getattr_call(req, ino, &e);
+  if (result < 0) fuse_reply_err(req, -result);
+  else fuse_reply_attr(req, &(e.attr), e.attr_timeout);
+}
+
+static void bindings_ll_symlink (fuse_req_t req, const char *link, fuse_ino_t parent, const char *name) {
+  bindings_req_t *r = bindings_ll_context(req);
+  bindings_t *b = r->b;
+  struct fuse_entry_param e;
+  bindings_ll_entry_init(b, &e);
+
+  r->op = OP_SYMLINK;
+  r->ino = parent;
+  r->name = (char *) name;
+  r->path = (char *) link; // not a path of this mount, only used to pass the target along
+  r->data = &e;
+
+  bindings_ll_reply_entry(req, bindings_call(r), &e);
+}
+
+static void bindings_ll_rename (fuse_req_t req, fuse_ino_t parent, const char *name, fuse_ino_t newparent, const char *newname) {
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_RENAME;
+  r->ino = parent;
+  r->name = (char *) name;
+  r->length = newparent;
+  r->data = (void *) newname;
+
+  fuse_reply_err(req, -bindings_call(r));
+}
+
+static void bindings_ll_link (fuse_req_t req, fuse_ino_t ino, fuse_ino_t newparent, const char *newname) {
+  bindings_req_t *r = bindings_ll_context(req);
+  bindings_t *b = r->b;
+  struct fuse_entry_param e;
+  bindings_ll_entry_init(b, &e);
+
+  r->op = OP_LINK;
+  r->ino = ino;
+  r->name = (char *) newname;
+  r->length = newparent;
+  r->data = &e;
+
+  bindings_ll_reply_entry(req, bindings_call(r), &e);
+}
+
+#ifdef __APPLE__
+static void bindings_ll_setxattr (fuse_req_t req, fuse_ino_t ino, const char *name, const char *value, size_t size, int flags, uint32_t position) {
+#else
+static void bindings_ll_setxattr (fuse_req_t req, fuse_ino_t ino, const char *name, const char *value, size_t size, int flags) {
+  uint32_t position = 0;
+#endif
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_SETXATTR;
+  r->ino = ino;
+  r->name = (char *) name;
+  r->data = (void *) value;
+  r->length = size;
+  r->offset = position;
+  r->mode = flags;
+
+  fuse_reply_err(req, -bindings_call(r));
+}
+
+// a size of 0 asks how big the value is, the handler gets an empty buffer and returns the length as usual
+static void bindings_ll_xattr_reply (fuse_req_t req, int result, char *buf, size_t size) {
+  if (result < 0) fuse_reply_err(req, -result);
+  else if (size == 0) fuse_reply_xattr(req, result);
+  else fuse_reply_buf(req, buf, result);
+  free(buf);
+}
+
+#ifdef __APPLE__
+static void bindings_ll_getxattr (fuse_req_t req, fuse_ino_t ino, const char *name, size_t size, uint32_t position) {
+#else
+static void bindings_ll_getxattr (fuse_req_t req, fuse_ino_t ino, const char *name, size_t size) {
+  uint32_t position = 0;
+#endif
+  bindings_t *b = (bindings_t *) fuse_req_userdata(req);
+  bindings_xattr_rule_t *rule = position == 0 ? bindings_xattr_rule(b, name) : NULL;
+
+  // the policy only looks at the name, so it works the same as on path based mounts
+  if (rule != NULL && !rule->pass) {
+    if (rule->value == NULL) fuse_reply_err(req, -rule->result);
+    else if (size == 0) fuse_reply_xattr(req, rule->value_length);
+    else if (rule->value_length > size) fuse_reply_err(req, ERANGE);
+    else fuse_reply_buf(req, rule->value, rule->value_length);
+    return;
+  }
+
+  if (b->ops_getxattr == NULL) {
+    fuse_reply_err(req, BINDINGS_ENOATTR);
+    return;
+  }
+
+  bindings_req_t *r = bindings_ll_context(req);
+  char *buf = size ? (char *) malloc(size) : NULL;
+
+  r->op = OP_GETXATTR;
+  r->ino = ino;
+  r->name = (char *) name;
+  r->data = (void *) buf;
+  r->length = size;
+  r->offset = position;
+
+  bindings_ll_xattr_reply(req, bindings_call(r), buf, size);
+}
+
+static void bindings_ll_listxattr (fuse_req_t req, fuse_ino_t ino, size_t size) {
+  bindings_req_t *r = bindings_ll_context(req);
+  char *buf = size ? (char *) malloc(size) : NULL;
+
+  r->op = OP_LISTXATTR;
+  r->ino = ino;
+  r->data = (void *) buf;
+  r->length = size;
+
+  bindings_ll_xattr_reply(req, bindings_call(r), buf, size);
+}
+
+static void bindings_ll_removexattr (fuse_req_t req, fuse_ino_t ino, const char *name) {
+  bindings_req_t *r = bindings_ll_context(req);
+
+  r->op = OP_REMOVEXATTR;
+  r->ino = ino;
+  r->name = (char *) name;
+
+  fuse_reply_err(req, -bindings_call(r));
+}
+
+static struct fuse_session *bindings_ll_session (bindings_t *b, struct fuse_args *args) {
+  struct fuse_lowlevel_ops ops = { };
+
+  if (b->ops_lookup != NULL) ops.lookup = bindings_ll_lookup;
+  if (b->ops_forget != NULL) ops.forget = bindings_ll_forget;
+  if (b->ops_getattr != NULL) ops.getattr = bindings_ll_getattr;
+  if (b->ops_chmod != NULL || b->ops_chown != NULL || b->ops_truncate != NULL || b->ops_utimens != NULL) ops.setattr = bindings_ll_setattr;
+  if (b->ops_readlink != NULL) ops.readlink = bindings_ll_readlink;
+  if (b->ops_symlink != NULL) ops.symlink = bindings_ll_symlink;
+  if (b->ops_rename != NULL) ops.rename = bindings_ll_rename;
+  if (b->ops_link != NULL) ops.link = bindings_ll_link;
+  if (b->ops_mknod != NULL) ops.mknod = bindings_ll_mknod;
+  if (b->ops_mkdir != NULL) ops.mkdir = bindings_ll_mkdir;
+  if (b->ops_unlink != NULL) ops.unlink = bindings_ll_unlink;
+  if (b->ops_rmdir != NULL) ops.rmdir = bindings_ll_rmdir;
+  if (b->ops_open != NULL) ops.open = bindings_ll_open;
+  if (b->ops_opendir != NULL) ops.opendir = bindings_ll_opendir;
+  if (b->ops_create != NULL) ops.create = bindings_ll_create;
+  if (b->ops_read != NULL) ops.read = bindings_ll_read;
+  if (b->ops_write != NULL) ops.write = bindings_ll_write;
+  if (b->ops_flush != NULL || b->write_buffer_size > 0) ops.flush = bindings_ll_flush;
+  ops.release = bindings_ll_release; // also frees file table slots
+  ops.releasedir = bindings_ll_releasedir;
+  if (b->ops_fsync != NULL || b->write_buffer_size > 0) ops.fsync = bindings_ll_fsync;
+  if (b->ops_readdir != NULL) ops.readdir = bindings_ll_readdir;
+  if (b->ops_statfs != NULL) ops.statfs = bindings_ll_statfs;
+  if (b->ops_setxattr != NULL) ops.setxattr = bindings_ll_setxattr;
+  if (b->ops_getxattr != NULL || b->xattr_rules != NULL) ops.getxattr = bindings_ll_getxattr;
+  if (b->ops_listxattr != NULL) ops.listxattr = bindings_ll_listxattr;
+  if (b->ops_removexattr != NULL) ops.removexattr = bindings_ll_removexattr;
+  if (b->ops_init != NULL) ops.init = bindings_ll_init;
+  if (b->ops_destroy != NULL) ops.destroy = bindings_ll_destroy;
+
+  return fuse_lowlevel_new(args, &ops, sizeof(struct fuse_lowlevel_ops), b);
+}
+#endif
+
+// frees what belongs to the isolate of the thread that created b
+static void bindings_free_js (bindings_t *b) {
+  if (b->files != NULL) {
+    b->files->Reset();
+    delete b->files;
+    free(b->files_gen);
+    free(b->files_free);
+  }
+
+  if (b->ops_access != NULL) delete b->ops_access;
+  if (b->ops_truncate != NULL) delete b->ops_truncate;
   if (b->ops_ftruncate != NULL) delete b->ops_ftruncate;
   if (b->ops_getattr != NULL) delete b->ops_getattr;
   if (b->ops_fgetattr != NULL) delete b->ops_fgetattr;
@@ -640,13 +2654,94 @@ static void bindings_free (bindings_t *b) {
   if (b->ops_rmdir != NULL) delete b->ops_rmdir;
   if (b->ops_init != NULL) delete b->ops_init;
   if (b->ops_destroy != NULL) delete b->ops_destroy;
-  if (b->callback != NULL) delete b->callback;
+  if (b->ops_lookup != NULL) delete b->ops_lookup;
+  if (b->ops_forget != NULL) delete b->ops_forget;
+
+  if (b->path_cache != NULL) {
+    cache_destroy(b->path_cache);
+    free(b->path_cache);
+    b->path_cache = NULL;
+  }
+}
+
+static void bindings_free (bindings_t *b) {
+  // workers free theirs on their own thread before the mount goes
+  if (b->parent == NULL) bindings_free_js(b);
+
+  while (b->reqs_free != NULL) {
+    bindings_req_t *r = b->reqs_free;
+    b->reqs_free = r->next;
+    if (r->callback != NULL) delete r->callback;
+    semaphore_destroy(&(r->semaphore));
+    free(r);
+  }
+
+  mutex_destroy(&(b->lock));
+  free(b->ring);
+  free(b->mnt);
+
+  // worker targets share the stats and attr cache of the mount
+  if (b->parent != NULL) {
+    free(b);
+    return;
+  }
+
+  free(b->mntopts);
+
+  for (int i = 0; i < BINDINGS_OPS_LENGTH; i++) free(b->stats[i]);
+  free(b->stats);
+
+  if (b->attr_cache != NULL) {
+    cache_destroy(b->attr_cache);
+    free(b->attr_cache);
+  }
+
+  matcher_destroy(b->negative_rules);
+  free(b->negative_rules);
+
+  if (b->negative_cache != NULL) {
+    cache_destroy(b->negative_cache);
+    free(b->negative_cache);
+  }
+
+  for (uint32_t i = 0; i < b->xattr_rules_length; i++) {
+    free(b->xattr_rules[i].name);
+    free(b->xattr_rules[i].value);
+  }
+  free(b->xattr_rules);
+
+  if (b->xattr_cache != NULL) {
+    cache_destroy(b->xattr_cache);
+    free(b->xattr_cache);
+  }
+
+  if (b->write_buffer_size > 0) {
+    while (b->wb != NULL) {
+      bindings_wb_t *wb = b->wb;
+      b->wb = wb->next;
+      bindings_wb_destroy(wb);
+    }
+    mutex_destroy(&(b->wb_lock));
+  }
+
+  if (b->read_cache != NULL) {
+    cache_destroy(b->read_cache);
+    cache_destroy(b->read_state);
+    free(b->read_cache);
+    free(b->read_state);
+    mutex_destroy(&(b->rc_lock));
+  }
 
-  bindings_mounted[b->index] = NULL;
-  while (bindings_mounted_count > 0 && bindings_mounted[bindings_mounted_count - 1] == NULL) {
-    bindings_mounted_count--;
+  // the js side of every worker is gone by now, see bindings_on_worker_close
+  if (b->workers != NULL) {
+    for (uint32_t i = 0; i < b->workers_length; i++) {
+      if (b->workers[i] != NULL) bindings_free(b->workers[i]);
+    }
+    semaphore_destroy(&(b->workers_closed));
+    free(b->workers);
   }
 
+  bindings_registry_remove(b);
   free(b);
 }
 
@@ -656,9 +2751,38 @@ static void bindings_on_close (uv_handle_t *handle) {
   mutex_unlock(&mutex);
 }
 
-static thread_fn_rtn_t bindings_thread (void *data) {
-  bindings_t *b = (bindings_t *) data;
+// the rest of t is freed with the mount, other threads might still look at it until then
+static void bindings_on_worker_close (uv_handle_t *handle) {
+  bindings_t *t = (bindings_t *) handle->data;
+  bindings_t *b = t->parent;
+  bindings_free_js(t);
+  semaphore_signal(&(b->workers_closed));
+}
+
+// called on the fuse thread once it is done, workers close their handles before the mount is freed
+static void bindings_close (bindings_t *b) {
+  // prefetches finish on the js thread and still point at b
+  bindings_pin_wait(b);
+  while (atomic_get(&(b->prefetching)) > 0) thread_yield();
+  while (atomic_get(&(b->deferred)) > 0) thread_yield();
+
+  if (b->workers_length > 0) {
+    atomic_set(&(b->closing), 1);
+    for (uint32_t i = 0; i < b->workers_length; i++) bindings_wakeup(b->workers[i]);
+    for (uint32_t i = 0; i < b->workers_length; i++) semaphore_wait(&(b->workers_closed));
+  }
+
+  uv_close((uv_handle_t*) &(b->async), &bindings_on_close);
+}
+
+static void bindings_session_error (bindings_t *b) {
+  bindings_req_t *r = bindings_req_alloc(b);
+  r->op = OP_ERROR;
+  bindings_call(r);
+}
 
+// mounts b->mnt and creates its session, the error op is called if either fails
+static int bindings_session_open (bindings_t *b) {
   struct fuse_operations ops = { };
 
   if (b->ops_access != NULL) ops.access = bindings_access;
@@ -666,8 +2790,8 @@ static thread_fn_rtn_t bindings_thread (void *data) {
   if (b->ops_ftruncate != NULL) ops.ftruncate = bindings_ftruncate;
   if (b->ops_getattr != NULL) ops.getattr = bindings_getattr;
   if (b->ops_fgetattr != NULL) ops.fgetattr = bindings_fgetattr;
-  if (b->ops_flush != NULL) ops.flush = bindings_flush;
-  if (b->ops_fsync != NULL) ops.fsync = bindings_fsync;
+  if (b->ops_flush != NULL || b->write_buffer_size > 0) ops.flush = bindings_flush;
+  if (b->ops_fsync != NULL || b->write_buffer_size > 0) ops.fsync = bindings_fsync;
   if (b->ops_fsyncdir != NULL) ops.fsyncdir = bindings_fsyncdir;
   if (b->ops_readdir != NULL) ops.readdir = bindings_readdir;
   if (b->ops_readlink != NULL) ops.readlink = bindings_readlink;
@@ -675,7 +2799,7 @@ static thread_fn_rtn_t bindings_thread (void *data) {
   if (b->ops_chmod != NULL) ops.chmod = bindings_chmod;
   if (b->ops_mknod != NULL) ops.mknod = bindings_mknod;
   if (b->ops_setxattr != NULL) ops.setxattr = bindings_setxattr;
-  if (b->ops_getxattr != NULL) ops.getxattr = bindings_getxattr;
+  if (b->ops_getxattr != NULL || b->xattr_rules != NULL) ops.getxattr = bindings_getxattr;
   if (b->ops_listxattr != NULL) ops.listxattr = bindings_listxattr;
   if (b->ops_removexattr != NULL) ops.removexattr = bindings_removexattr;
   if (b->ops_statfs != NULL) ops.statfs = bindings_statfs;
@@ -683,8 +2807,12 @@ static thread_fn_rtn_t bindings_thread (void *data) {
   if (b->ops_opendir != NULL) ops.opendir = bindings_opendir;
   if (b->ops_read != NULL) ops.read = bindings_read;
   if (b->ops_write != NULL) ops.write = bindings_write;
-  if (b->ops_release != NULL) ops.release = bindings_release;
-  if (b->ops_releasedir != NULL) ops.releasedir = bindings_releasedir;
+#ifndef _WIN32
+  if (b->zero_copy && b->ops_read != NULL && b->read_cache == NULL) ops.read_buf = bindings_read_buf;
+  if (b->zero_copy && b->ops_write != NULL) ops.write_buf = bindings_write_buf;
+#endif
+  ops.release = bindings_release; // also frees file table slots
+  ops.releasedir = bindings_releasedir;
   if (b->ops_create != NULL) ops.create = bindings_create;
   if (b->ops_utimens != NULL) ops.utimens = bindings_utimens;
   if (b->ops_unlink != NULL) ops.unlink = bindings_unlink;
@@ -695,6 +2823,11 @@ static thread_fn_rtn_t bindings_thread (void *data) {
   if (b->ops_rmdir != NULL) ops.rmdir = bindings_rmdir;
   if (b->ops_init != NULL) ops.init = bindings_init;
   if (b->ops_destroy != NULL) ops.destroy = bindings_destroy;
+#ifndef _WIN32
+  // fuse stops building paths for ops that get a file handle
+  ops.flag_nullpath_ok = b->null_path;
+  ops.flag_nopath = b->null_path;
+#endif
 
   int argc = !strcmp(b->mntopts, "-o") ? 1 : 2;
   char *argv[] = {
@@ -705,32 +2838,263 @@ static thread_fn_rtn_t bindings_thread (void *data) {
   struct fuse_args args = FUSE_ARGS_INIT(argc, argv);
   struct fuse_chan *ch = fuse_mount(b->mnt, &args);
 
-  if (ch == NULL) {
-    b->op = OP_ERROR;
-    bindings_call(b);
-    uv_close((uv_handle_t*) &(b->async), &bindings_on_close);
-    return NULL;
+  if (ch == NULL) {
+    bindings_session_error(b);
+    return -1;
+  }
+
+#ifndef _WIN32
+  if (b->lowlevel) {
+    b->se = bindings_ll_session(b, &args);
+
+    if (b->se == NULL) {
+      bindings_session_error(b);
+      fuse_unmount(b->mnt, ch);
+      return -1;
+    }
+
+    fuse_session_add_chan(b->se, ch);
+  } else
+#endif
+  {
+    // a failed fuse_new destroys the channel with its session
+    b->fuse = fuse_new(ch, &args, &ops, sizeof(struct fuse_operations), b);
+
+    if (b->fuse == NULL) {
+      bindings_session_error(b);
+      return -1;
+    }
+
+#ifndef _WIN32
+    b->se = fuse_get_session(b->fuse);
+#endif
+  }
+
+  mutex_lock(&mutex);
+  b->ch = ch;
+  mutex_unlock(&mutex);
+
+  if (b->write_buffer_size > 0 && b->write_buffer_delay > 0) thread_create(&(b->wb_thread), bindings_wb_thread, b);
+  return 0;
+}
+
+static void bindings_session_close (bindings_t *b) {
+  if (b->write_buffer_size > 0 && b->write_buffer_delay > 0) {
+    atomic_set(&(b->wb_stop), 1);
+    thread_join(b->wb_thread);
+  }
+
+  mutex_lock(&mutex);
+  struct fuse_chan *ch = b->ch;
+  b->ch = NULL;
+  mutex_unlock(&mutex);
+
+  // notifications might still be writing to ch
+  bindings_pin_wait(b);
+
+#ifndef _WIN32
+  if (b->lowlevel) {
+    fuse_session_remove_chan(ch);
+    fuse_session_destroy(b->se);
+    fuse_unmount(b->mnt, ch);
+    return;
+  }
+#endif
+
+  fuse_unmount(b->mnt, ch);
+  fuse_session_remove_chan(ch);
+  fuse_destroy(b->fuse);
+}
+
+static thread_fn_rtn_t bindings_thread (void *data) {
+  bindings_t *b = (bindings_t *) data;
+
+  if (bindings_session_open(b) < 0) {
+    bindings_close(b);
+    return 0;
+  }
+
+#ifndef _WIN32
+  if (b->lowlevel) {
+    if (b->multithreaded) fuse_session_loop_mt(b->se);
+    else fuse_session_loop(b->se);
+  } else
+#endif
+  {
+    if (b->multithreaded) fuse_loop_mt(b->fuse);
+    else fuse_loop(b->fuse);
+  }
+
+  bindings_session_close(b);
+  bindings_close(b);
+
+  return 0;
+}
+
+#ifdef __linux__
+// the shared driver puts the fd of every session on one epoll set served by a few threads.
+// fds are armed one shot, so a session is only ever read and processed by one thread at a time
+static int bindings_driver_epoll = -1;
+static int bindings_driver_wakeup = -1; // counts the mounts waiting in bindings_driver_pending
+static bindings_t *bindings_driver_pending = NULL;
+static uint32_t bindings_driver_size = 0; // threads kept around when nothing is in flight
+static volatile uint32_t bindings_driver_idle = 0; // threads waiting on the epoll set
+
+static thread_fn_rtn_t bindings_driver_thread (void *data);
+
+static void bindings_driver_spawn () {
+  abstr_thread_t thread;
+  atomic_add(&bindings_driver_idle, 1);
+  thread_create(&thread, bindings_driver_thread, NULL);
+  pthread_detach(thread);
+}
+
+static void bindings_driver_arm (bindings_t *b, int op) {
+  struct epoll_event ev = { };
+  ev.events = EPOLLIN | EPOLLONESHOT;
+  ev.data.ptr = b;
+  epoll_ctl(bindings_driver_epoll, op, fuse_chan_fd(b->ch), &ev);
+}
+
+// an unmount waiting for b is woken once b is closed, see bindings_unmount_start
+static void bindings_driver_close (bindings_t *b) {
+  mutex_lock(&mutex);
+  bindings_sem_t *unmounted = b->unmounted;
+  b->stopped = 1;
+  mutex_unlock(&mutex);
+
+  bindings_close(b);
+  if (unmounted != NULL) semaphore_signal(unmounted);
+}
+
+static void bindings_driver_start (bindings_t *b) {
+  if (bindings_session_open(b) < 0) {
+    bindings_driver_close(b);
+    return;
+  }
+
+  bindings_driver_arm(b, EPOLL_CTL_ADD);
+}
+
+static void bindings_driver_stop (bindings_t *b) {
+  epoll_ctl(bindings_driver_epoll, EPOLL_CTL_DEL, fuse_chan_fd(b->ch), NULL);
+  bindings_session_close(b);
+  bindings_driver_close(b);
+}
+
+static void bindings_driver_event (struct epoll_event *ev, char **buf, size_t *buf_size) {
+  // new mounts are set up by whichever thread wins the wakeup
+  if (ev->data.ptr == NULL) {
+    uint64_t count;
+    if (read(bindings_driver_wakeup, &count, sizeof(count)) < 0) return;
+
+    mutex_lock(&mutex);
+    bindings_t *b = bindings_driver_pending;
+    bindings_driver_pending = b->driver_next;
+    mutex_unlock(&mutex);
+
+    bindings_driver_start(b);
+    return;
+  }
+
+  bindings_t *b = (bindings_t *) ev->data.ptr;
+  struct fuse_chan *ch = b->ch;
+  size_t size = fuse_chan_bufsize(ch);
+
+  if (size > *buf_size) {
+    *buf = (char *) realloc(*buf, size);
+    *buf_size = size;
+  }
+
+  struct fuse_buf fbuf = { };
+  fbuf.mem = *buf;
+  fbuf.size = size;
+
+  int res = fuse_session_receive_buf(b->se, &fbuf, &ch);
+  if (res > 0) fuse_session_process_buf(b->se, &fbuf, ch);
+
+  if (res == -EINTR || res == -EAGAIN || (res > 0 && !fuse_session_exited(b->se))) {
+    bindings_driver_arm(b, EPOLL_CTL_MOD);
+    return;
+  }
+
+  // unmounted, the kernel answers reads with ENODEV from here on
+  bindings_driver_stop(b);
+}
+
+static thread_fn_rtn_t bindings_driver_thread (void *data) {
+  char *buf = NULL;
+  size_t buf_size = 0;
+  struct epoll_event ev;
+
+  while (1) {
+    if (epoll_wait(bindings_driver_epoll, &ev, 1, -1) < 1) continue;
+
+    // a handler can keep this thread for as long as it likes, so make sure someone
+    // is still waiting on the set for the other mounts and for new ones
+    if (atomic_add(&bindings_driver_idle, -1) == 0) bindings_driver_spawn();
+
+    bindings_driver_event(&ev, &buf, &buf_size);
+
+    // threads spawned for slow handlers go away again once the pool has enough idle ones
+    uint32_t idle = atomic_add(&bindings_driver_idle, 1);
+    if (idle > bindings_driver_size && atomic_cas(&bindings_driver_idle, idle, idle - 1)) break;
   }
 
-  struct fuse *fuse = fuse_new(ch, &args, &ops, sizeof(struct fuse_operations), b);
+  free(buf);
+  return 0;
+}
+
+// called with the global mutex held, the pool is sized by the first mount that uses it
+static int bindings_driver_init (uint32_t threads) {
+  if (bindings_driver_epoll != -1) return 0;
 
-  if (fuse == NULL) {
-    b->op = OP_ERROR;
-    bindings_call(b);
-    uv_close((uv_handle_t*) &(b->async), &bindings_on_close);
-    return NULL;
+  int epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (epfd == -1) return -1;
+
+  int wakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+  if (wakeup == -1) {
+    close(epfd);
+    return -1;
   }
 
-  fuse_loop(fuse);
+  struct epoll_event ev = { };
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;
+  epoll_ctl(epfd, EPOLL_CTL_ADD, wakeup, &ev);
 
-  fuse_unmount(b->mnt, ch);
-  fuse_session_remove_chan(ch);
-  fuse_destroy(fuse);
+  bindings_driver_epoll = epfd;
+  bindings_driver_wakeup = wakeup;
+  bindings_driver_size = threads;
 
-  uv_close((uv_handle_t*) &(b->async), &bindings_on_close);
+  for (uint32_t i = 0; i < threads; i++) bindings_driver_spawn();
 
   return 0;
 }
+#endif
+
+// mounts on the shared driver if asked to, otherwise on a thread of its own
+static void bindings_start (bindings_t *b) {
+#ifdef __linux__
+  mutex_lock(&mutex);
+  int shared = b->shared > 0 && bindings_driver_init(b->shared) == 0;
+  if (shared) {
+    b->driver_next = bindings_driver_pending;
+    bindings_driver_pending = b;
+  }
+  mutex_unlock(&mutex);
+
+  if (shared) {
+    uint64_t one = 1;
+    ssize_t n = write(bindings_driver_wakeup, &one, sizeof(one));
+    (void) n;
+    return;
+  }
+#endif
+
+  b->shared = 0;
+  thread_create(&(b->thread), bindings_thread, b);
+}
 
 NAN_INLINE static Local<Date> bindings_get_date (struct timespec *out) {
   int ms = (out->tv_nsec / 1000);
@@ -739,6 +3103,7 @@ NAN_INLINE static Local<Date> bindings_get_date (struct timespec *out) {
 
 NAN_INLINE static void bindings_set_date (struct timespec *out, Local<Date> date) {
   double ms = date->NumberValue();
+  if (!std::isfinite(ms)) ms = 0; // invalid dates
   time_t secs = (time_t)(ms / 1000.0);
   time_t rem = ms - (1000.0 * secs);
   time_t ns = rem * 1000000.0;
@@ -746,120 +3111,579 @@ NAN_INLINE static void bindings_set_date (struct timespec *out, Local<Date> date
   out->tv_nsec = ns;
 }
 
+// packed stat replies are a Float64Array or BigInt64Array with these slots
+enum bindings_stat_field_t {
+  STAT_DEV = 0,
+  STAT_INO,
+  STAT_MODE,
+  STAT_NLINK,
+  STAT_UID,
+  STAT_GID,
+  STAT_RDEV,
+  STAT_SIZE,
+  STAT_BLOCKS,
+  STAT_BLKSIZE,
+  STAT_ATIME_SEC,
+  STAT_ATIME_NSEC,
+  STAT_MTIME_SEC,
+  STAT_MTIME_NSEC,
+  STAT_CTIME_SEC,
+  STAT_CTIME_NSEC,
+  STAT_LENGTH
+};
+
+// stat objects have a single Date per time where packed stats have two slots
+#define STAT_KEYS (STAT_ATIME_SEC + 3)
+
+enum bindings_statfs_field_t {
+  STATFS_BSIZE = 0,
+  STATFS_FRSIZE,
+  STATFS_BLOCKS,
+  STATFS_BFREE,
+  STATFS_BAVAIL,
+  STATFS_FILES,
+  STATFS_FFREE,
+  STATFS_FAVAIL,
+  STATFS_FSID,
+  STATFS_FLAG,
+  STATFS_NAMEMAX,
+  STATFS_LENGTH
+};
+
+#if V8_MAJOR_VERSION > 6 || (V8_MAJOR_VERSION == 6 && V8_MINOR_VERSION >= 7)
+#define BINDINGS_HAS_BIGINT64ARRAY
+#endif
+
+// property names of stat objects are created once instead of per reply
+static const char *bindings_stat_names[STAT_KEYS] = {"dev", "ino", "mode", "nlink", "uid", "gid", "rdev", "size", "blocks", "blksize", "atime", "mtime", "ctime"};
+static const char *bindings_statfs_names[] = {"bsize", "frsize", "blocks", "bfree", "bavail", "files", "ffree", "favail", "fsid", "flag", "namemax"};
+static THREAD_LOCAL Nan::Persistent<String> *bindings_stat_keys = NULL;
+static THREAD_LOCAL Nan::Persistent<String> *bindings_statfs_keys = NULL;
+
+static void bindings_init_keys () {
+  if (bindings_stat_keys != NULL) return;
+  bindings_stat_keys = new Nan::Persistent<String>[STAT_KEYS];
+  bindings_statfs_keys = new Nan::Persistent<String>[STATFS_LENGTH];
+  for (int i = 0; i < STAT_KEYS; i++) bindings_stat_keys[i].Reset(LOCAL_STRING(bindings_stat_names[i]));
+  for (int i = 0; i < STATFS_LENGTH; i++) bindings_statfs_keys[i].Reset(LOCAL_STRING(bindings_statfs_names[i]));
+}
+
+NAN_INLINE static int bindings_is_packed (Local<Object> obj) {
+#ifdef BINDINGS_HAS_BIGINT64ARRAY
+  if (obj->IsBigInt64Array()) return 1;
+#endif
+  return obj->IsFloat64Array();
+}
+
+// NaN becomes 0 and anything out of range the nearest int64, casting those is undefined
+NAN_INLINE static int64_t bindings_to_int64 (double val) {
+  if (std::isnan(val)) return 0;
+  if (val >= 9223372036854775807.0) return INT64_MAX;
+  if (val <= -9223372036854775808.0) return INT64_MIN;
+  return (int64_t) val;
+}
+
+static void bindings_get_packed (Local<Object> obj, int64_t *out, size_t length) {
+  memset(out, 0, length * sizeof(int64_t));
+
+#ifdef BINDINGS_HAS_BIGINT64ARRAY
+  if (obj->IsBigInt64Array()) {
+    Nan::TypedArrayContents<int64_t> arr(obj);
+    memcpy(out, *arr, (arr.length() < length ? arr.length() : length) * sizeof(int64_t));
+    return;
+  }
+#endif
+
+  Nan::TypedArrayContents<double> arr(obj);
+  for (size_t i = 0; i < arr.length() && i < length; i++) out[i] = bindings_to_int64((*arr)[i]);
+}
+
+NAN_INLINE static void bindings_set_timespec (struct timespec *out, int64_t sec, int64_t nsec) {
+  out->tv_sec = sec;
+  out->tv_nsec = nsec;
+}
+
+static void bindings_set_stat_packed (struct FUSE_STAT *stat, Local<Object> obj) {
+  int64_t v[STAT_LENGTH];
+  bindings_get_packed(obj, v, STAT_LENGTH);
+
+  stat->st_dev = v[STAT_DEV];
+  stat->st_ino = v[STAT_INO];
+  stat->st_mode = v[STAT_MODE];
+  stat->st_nlink = v[STAT_NLINK];
+  stat->st_uid = v[STAT_UID];
+  stat->st_gid = v[STAT_GID];
+  stat->st_rdev = v[STAT_RDEV];
+  stat->st_size = v[STAT_SIZE];
+  stat->st_blocks = v[STAT_BLOCKS];
+  stat->st_blksize = v[STAT_BLKSIZE];
+#ifdef __APPLE__
+  bindings_set_timespec(&stat->st_atimespec, v[STAT_ATIME_SEC], v[STAT_ATIME_NSEC]);
+  bindings_set_timespec(&stat->st_mtimespec, v[STAT_MTIME_SEC], v[STAT_MTIME_NSEC]);
+  bindings_set_timespec(&stat->st_ctimespec, v[STAT_CTIME_SEC], v[STAT_CTIME_NSEC]);
+#else
+  bindings_set_timespec(&stat->st_atim, v[STAT_ATIME_SEC], v[STAT_ATIME_NSEC]);
+  bindings_set_timespec(&stat->st_mtim, v[STAT_MTIME_SEC], v[STAT_MTIME_NSEC]);
+  bindings_set_timespec(&stat->st_ctim, v[STAT_CTIME_SEC], v[STAT_CTIME_NSEC]);
+#endif
+}
+
 NAN_INLINE static void bindings_set_stat (struct FUSE_STAT *stat, Local<Object> obj) {
-  if (obj->Has(LOCAL_STRING("dev"))) stat->st_dev = obj->Get(LOCAL_STRING("dev"))->NumberValue();
-  if (obj->Has(LOCAL_STRING("ino"))) stat->st_ino = obj->Get(LOCAL_STRING("ino"))->NumberValue();
-  if (obj->Has(LOCAL_STRING("mode"))) stat->st_mode = obj->Get(LOCAL_STRING("mode"))->Uint32Value();
-  if (obj->Has(LOCAL_STRING("nlink"))) stat->st_nlink = obj->Get(LOCAL_STRING("nlink"))->NumberValue();
-  if (obj->Has(LOCAL_STRING("uid"))) stat->st_uid = obj->Get(LOCAL_STRING("uid"))->NumberValue();
-  if (obj->Has(LOCAL_STRING("gid"))) stat->st_gid = obj->Get(LOCAL_STRING("gid"))->NumberValue();
-  if (obj->Has(LOCAL_STRING("rdev"))) stat->st_rdev = obj->Get(LOCAL_STRING("rdev"))->NumberValue();
-  if (obj->Has(LOCAL_STRING("size"))) stat->st_size = obj->Get(LOCAL_STRING("size"))->NumberValue();
-  if (obj->Has(LOCAL_STRING("blocks"))) stat->st_blocks = obj->Get(LOCAL_STRING("blocks"))->NumberValue();
-  if (obj->Has(LOCAL_STRING("blksize"))) stat->st_blksize = obj->Get(LOCAL_STRING("blksize"))->NumberValue();
+  if (bindings_is_packed(obj)) {
+    bindings_set_stat_packed(stat, obj);
+    return;
+  }
+
+  Local<Value> v[STAT_KEYS];
+  for (int i = 0; i < STAT_KEYS; i++) v[i] = obj->Get(Nan::New(bindings_stat_keys[i]));
+
+  if (!v[0]->IsUndefined()) stat->st_dev = v[0]->NumberValue();
+  if (!v[1]->IsUndefined()) stat->st_ino = v[1]->NumberValue();
+  if (!v[2]->IsUndefined()) stat->st_mode = v[2]->Uint32Value();
+  if (!v[3]->IsUndefined()) stat->st_nlink = v[3]->NumberValue();
+  if (!v[4]->IsUndefined()) stat->st_uid = v[4]->NumberValue();
+  if (!v[5]->IsUndefined()) stat->st_gid = v[5]->NumberValue();
+  if (!v[6]->IsUndefined()) stat->st_rdev = v[6]->NumberValue();
+  if (!v[7]->IsUndefined()) stat->st_size = v[7]->NumberValue();
+  if (!v[8]->IsUndefined()) stat->st_blocks = v[8]->NumberValue();
+  if (!v[9]->IsUndefined()) stat->st_blksize = v[9]->NumberValue();
 #ifdef __APPLE__
-  if (obj->Has(LOCAL_STRING("mtime"))) bindings_set_date(&stat->st_mtimespec, obj->Get(LOCAL_STRING("mtime")).As<Date>());
-  if (obj->Has(LOCAL_STRING("ctime"))) bindings_set_date(&stat->st_ctimespec, obj->Get(LOCAL_STRING("ctime")).As<Date>());
-  if (obj->Has(LOCAL_STRING("atime"))) bindings_set_date(&stat->st_atimespec, obj->Get(LOCAL_STRING("atime")).As<Date>());
+  if (!v[10]->IsUndefined()) bindings_set_date(&stat->st_atimespec, v[10].As<Date>());
+  if (!v[11]->IsUndefined()) bindings_set_date(&stat->st_mtimespec, v[11].As<Date>());
+  if (!v[12]->IsUndefined()) bindings_set_date(&stat->st_ctimespec, v[12].As<Date>());
 #else
-  if (obj->Has(LOCAL_STRING("mtime"))) bindings_set_date(&stat->st_mtim, obj->Get(LOCAL_STRING("mtime")).As<Date>());
-  if (obj->Has(LOCAL_STRING("ctime"))) bindings_set_date(&stat->st_ctim, obj->Get(LOCAL_STRING("ctime")).As<Date>());
-  if (obj->Has(LOCAL_STRING("atime"))) bindings_set_date(&stat->st_atim, obj->Get(LOCAL_STRING("atime")).As<Date>());
+  if (!v[10]->IsUndefined()) bindings_set_date(&stat->st_atim, v[10].As<Date>());
+  if (!v[11]->IsUndefined()) bindings_set_date(&stat->st_mtim, v[11].As<Date>());
+  if (!v[12]->IsUndefined()) bindings_set_date(&stat->st_ctim, v[12].As<Date>());
 #endif
 }
 
 NAN_INLINE static void bindings_set_statfs (struct statvfs *statfs, Local<Object> obj) { // from http://linux.die.net/man/2/stat
-  if (obj->Has(LOCAL_STRING("bsize"))) statfs->f_bsize = obj->Get(LOCAL_STRING("bsize"))->Uint32Value();
-  if (obj->Has(LOCAL_STRING("frsize"))) statfs->f_frsize = obj->Get(LOCAL_STRING("frsize"))->Uint32Value();
-  if (obj->Has(LOCAL_STRING("blocks"))) statfs->f_blocks = obj->Get(LOCAL_STRING("blocks"))->Uint32Value();
-  if (obj->Has(LOCAL_STRING("bfree"))) statfs->f_bfree = obj->Get(LOCAL_STRING("bfree"))->Uint32Value();
-  if (obj->Has(LOCAL_STRING("bavail"))) statfs->f_bavail = obj->Get(LOCAL_STRING("bavail"))->Uint32Value();
-  if (obj->Has(LOCAL_STRING("files"))) statfs->f_files = obj->Get(LOCAL_STRING("files"))->Uint32Value();
-  if (obj->Has(LOCAL_STRING("ffree"))) statfs->f_ffree = obj->Get(LOCAL_STRING("ffree"))->Uint32Value();
-  if (obj->Has(LOCAL_STRING("favail"))) statfs->f_favail = obj->Get(LOCAL_STRING("favail"))->Uint32Value();
-  if (obj->Has(LOCAL_STRING("fsid"))) statfs->f_fsid = obj->Get(LOCAL_STRING("fsid"))->Uint32Value();
-  if (obj->Has(LOCAL_STRING("flag"))) statfs->f_flag = obj->Get(LOCAL_STRING("flag"))->Uint32Value();
-  if (obj->Has(LOCAL_STRING("namemax"))) statfs->f_namemax = obj->Get(LOCAL_STRING("namemax"))->Uint32Value();
-}
-
-class SetDirWorker : public Nan::AsyncWorker {
- public:
-  SetDirWorker(bindings_t *b, char **dirs, int dirs_length)
-    : Nan::AsyncWorker(NULL), b(b), dirs(dirs), dirs_length(dirs_length) {}
-  ~SetDirWorker() {}
+  int64_t v[STATFS_LENGTH];
 
-  void Execute () {
-    fuse_fill_dir_t fillerToCall = b->filler;
-    void *data = b->data;
-    for (int i = 0; i < dirs_length; i++) {
-      fillerToCall(data, dirs[i], &empty_stat, 0);
+  if (bindings_is_packed(obj)) {
+    bindings_get_packed(obj, v, STATFS_LENGTH);
+  } else {
+    for (int i = 0; i < STATFS_LENGTH; i++) {
+      Local<Value> val = obj->Get(Nan::New(bindings_statfs_keys[i]));
+      v[i] = val->IsUndefined() ? -1 : val->Uint32Value();
     }
   }
-  void WorkComplete(){
-    semaphore_signal(&(b->semaphore_readdir));
-    for (int i = 0; i < dirs_length; i++) {
-      free(dirs[i]);
+
+  if (v[STATFS_BSIZE] != -1) statfs->f_bsize = v[STATFS_BSIZE];
+  if (v[STATFS_FRSIZE] != -1) statfs->f_frsize = v[STATFS_FRSIZE];
+  if (v[STATFS_BLOCKS] != -1) statfs->f_blocks = v[STATFS_BLOCKS];
+  if (v[STATFS_BFREE] != -1) statfs->f_bfree = v[STATFS_BFREE];
+  if (v[STATFS_BAVAIL] != -1) statfs->f_bavail = v[STATFS_BAVAIL];
+  if (v[STATFS_FILES] != -1) statfs->f_files = v[STATFS_FILES];
+  if (v[STATFS_FFREE] != -1) statfs->f_ffree = v[STATFS_FFREE];
+  if (v[STATFS_FAVAIL] != -1) statfs->f_favail = v[STATFS_FAVAIL];
+  if (v[STATFS_FSID] != -1) statfs->f_fsid = v[STATFS_FSID];
+  if (v[STATFS_FLAG] != -1) statfs->f_flag = v[STATFS_FLAG];
+  if (v[STATFS_NAMEMAX] != -1) statfs->f_namemax = v[STATFS_NAMEMAX];
+}
+
+static void bindings_set_dirs (bindings_dir_t *dir, Local<Array> names, Local<Value> stats) {
+  uint32_t length = names->Length();
+  size_t size = 0;
+  size_t alloc = 4096;
+  char *arena = (char *) malloc(alloc);
+
+  for (uint32_t i = 0; i < length; i++) {
+    Nan::Utf8String name(names->Get(i));
+    size_t len = name.length() + 1;
+
+    if (size + len > alloc) {
+      while (size + len > alloc) alloc *= 2;
+      arena = (char *) realloc(arena, alloc);
     }
-    free(dirs);
+
+    memcpy(arena + size, *name, len);
+    size += len;
   }
- private:
-  bindings_t *b;
-  char **dirs;
-  int dirs_length;
-};
 
+  dir->names = arena;
+  dir->length = length;
+
+  if (stats->IsArray()) {
+    dir->stats = (struct FUSE_STAT *) calloc(length, sizeof(struct FUSE_STAT));
+    for (uint32_t i = 0; i < length; i++) {
+      Local<Value> st = stats.As<Array>()->Get(i);
+      if (st->IsObject()) bindings_set_stat(dir->stats + i, st.As<Object>());
+    }
+  }
+}
+
+static void bindings_attr_cache_put (bindings_req_t *r, struct FUSE_STAT *stat, Local<Value> ttl) {
+  bindings_t *b = r->b;
+  double secs = ttl->IsNumber() ? ttl->NumberValue() : b->attr_cache_ttl;
+  if (secs <= 0) return;
+
+  uint64_t expires = uv_hrtime() + (uint64_t) (secs * 1e9);
+  if (b->lowlevel) bindings_attr_cache_put_since(b, b->attr_cache, r->attr_gen, &(r->ino), sizeof(r->ino), stat, sizeof(struct FUSE_STAT), expires);
+  else bindings_attr_cache_put_since(b, b->attr_cache, r->attr_gen, r->path, strlen(r->path), stat, sizeof(struct FUSE_STAT), expires);
+}
+
+static void bindings_attr_cache_del (cache_t *cache, const char *path, bool subtree) {
+  if (path == NULL) return;
+
+  size_t len = strlen(path);
+  cache_del(cache, path, len);
+
+  if (subtree) {
+    char *prefix = (char *) malloc(len + 2);
+    memcpy(prefix, path, len);
+    prefix[len] = '/';
+    prefix[len + 1] = '\0';
+    cache_del_prefix(cache, prefix, len + 1);
+    free(prefix);
+  }
+}
+
+static void bindings_attr_cache_del_parent (cache_t *cache, const char *path) {
+  if (path == NULL) return;
+
+  const char *slash = strrchr(path, '/');
+  if (slash == NULL) return;
+  cache_del(cache, path, slash == path ? 1 : slash - path);
+}
+
+// drop whatever a mutating op may have made stale, the parent directory included
+static void bindings_attr_cache_invalidate (bindings_req_t *r) {
+  cache_t *cache = r->b->attr_cache;
+
+  if (r->b->lowlevel) {
+    switch (r->op) {
+      case OP_WRITE:
+      case OP_FORGET:
+      case OP_MKNOD:
+      case OP_MKDIR:
+      case OP_CREATE:
+      case OP_UNLINK:
+      case OP_RMDIR:
+      case OP_CHMOD:
+      case OP_CHOWN:
+      case OP_TRUNCATE:
+      case OP_UTIMENS:
+      case OP_SETXATTR:
+      case OP_REMOVEXATTR:
+      case OP_SYMLINK:
+      case OP_LINK:
+      case OP_RENAME:
+      atomic_add(&(r->b->attr_gen), 1);
+      cache_del(cache, &(r->ino), sizeof(r->ino));
+      if (r->op == OP_LINK || r->op == OP_RENAME) {
+        uint64_t newparent = r->length;
+        cache_del(cache, &newparent, sizeof(newparent));
+      }
+      break;
+
+      default:
+      break;
+    }
+    return;
+  }
+
+  // which file a path-less write went to is unknown
+  if (r->path == NULL && (r->op == OP_WRITE || r->op == OP_FTRUNCATE)) {
+    atomic_add(&(r->b->attr_gen), 1);
+    cache_clear(cache);
+    return;
+  }
+
+  switch (r->op) {
+    case OP_WRITE:
+    case OP_TRUNCATE:
+    case OP_FTRUNCATE:
+    case OP_CHMOD:
+    case OP_CHOWN:
+    case OP_UTIMENS:
+    case OP_SETXATTR:
+    case OP_REMOVEXATTR:
+    atomic_add(&(r->b->attr_gen), 1);
+    bindings_attr_cache_del(cache, r->path, false);
+    break;
+
+    case OP_CREATE:
+    case OP_MKNOD:
+    case OP_MKDIR:
+    case OP_UNLINK:
+    atomic_add(&(r->b->attr_gen), 1);
+    bindings_attr_cache_del(cache, r->path, false);
+    bindings_attr_cache_del_parent(cache, r->path);
+    break;
+
+    case OP_RMDIR:
+    atomic_add(&(r->b->attr_gen), 1);
+    bindings_attr_cache_del(cache, r->path, true);
+    bindings_attr_cache_del_parent(cache, r->path);
+    break;
+
+    case OP_RENAME:
+    atomic_add(&(r->b->attr_gen), 1);
+    bindings_attr_cache_del(cache, r->path, true);
+    bindings_attr_cache_del_parent(cache, r->path);
+    bindings_attr_cache_del(cache, (char *) r->data, true);
+    bindings_attr_cache_del_parent(cache, (char *) r->data);
+    break;
+
+    case OP_LINK:
+    atomic_add(&(r->b->attr_gen), 1);
+    bindings_attr_cache_del(cache, r->path, false);
+    bindings_attr_cache_del(cache, (char *) r->data, false);
+    bindings_attr_cache_del_parent(cache, (char *) r->data);
+    break;
+
+    case OP_SYMLINK:
+    atomic_add(&(r->b->attr_gen), 1);
+    bindings_attr_cache_del(cache, (char *) r->data, false);
+    bindings_attr_cache_del_parent(cache, (char *) r->data);
+    break;
+
+    default:
+    break;
+  }
+}
+
+// a path that was missing can only appear through these
+static void bindings_negative_cache_invalidate (bindings_req_t *r) {
+  switch (r->op) {
+    case OP_CREATE:
+    case OP_MKNOD:
+    case OP_MKDIR:
+    atomic_add(&(r->b->attr_gen), 1);
+    bindings_attr_cache_del(r->b->negative_cache, r->path, false);
+    break;
+
+    case OP_LINK:
+    case OP_SYMLINK:
+    atomic_add(&(r->b->attr_gen), 1);
+    bindings_attr_cache_del(r->b->negative_cache, (char *) r->data, false);
+    break;
+
+    case OP_RENAME:
+    atomic_add(&(r->b->attr_gen), 1);
+    bindings_attr_cache_del(r->b->negative_cache, (char *) r->data, true);
+    break;
+
+    default:
+    break;
+  }
+}
+
+static void bindings_xattr_cache_invalidate (bindings_req_t *r) {
+  switch (r->op) {
+    case OP_SETXATTR:
+    case OP_REMOVEXATTR:
+    case OP_UNLINK:
+    bindings_xattr_cache_del(r->b->xattr_cache, r->path, false);
+    break;
+
+    case OP_RMDIR:
+    bindings_xattr_cache_del(r->b->xattr_cache, r->path, true);
+    break;
+
+    case OP_RENAME:
+    bindings_xattr_cache_del(r->b->xattr_cache, r->path, true);
+    bindings_xattr_cache_del(r->b->xattr_cache, (char *) r->data, true);
+    break;
+
+    default:
+    break;
+  }
+}
+
+#ifndef _WIN32
+static void bindings_ll_set_entry (struct fuse_entry_param *e, Local<Object> obj, Local<Value> ttl) {
+  bindings_set_stat(&(e->attr), obj);
+  e->ino = e->attr.st_ino;
+  if (obj->Has(LOCAL_STRING("generation"))) e->generation = obj->Get(LOCAL_STRING("generation"))->NumberValue();
+  if (ttl->IsNumber()) e->attr_timeout = e->entry_timeout = ttl->NumberValue();
+}
+
+static void bindings_ll_set_dirs (bindings_req_t *r, Local<Array> names, Local<Value> stats) {
+  char *buf = (char *) r->data;
+  size_t size = r->length;
+  size_t used = 0;
+  cache_t *cache = stats->IsArray() ? r->b->attr_cache : NULL;
+  struct FUSE_STAT stat;
+
+  // entries are numbered from the offset the kernel asked for, so it can resume after a full buffer
+  for (uint32_t i = 0; i < names->Length(); i++) {
+    Nan::Utf8String name(names->Get(i));
+
+    memset(&stat, 0, sizeof(stat));
+    if (stats->IsArray()) {
+      Local<Value> st = stats.As<Array>()->Get(i);
+      if (st->IsObject()) bindings_set_stat(&stat, st.As<Object>());
+    }
+
+    size_t len = fuse_add_direntry(r->ll, buf + used, size - used, *name, &stat, r->offset + i + 1);
+    if (len > size - used) break;
+    used += len;
+
+    if (stat.st_ino != 0 && cache != NULL && r->b->attr_cache_ttl > 0 && strcmp(*name, ".") && strcmp(*name, "..")) {
+      uint64_t ino = stat.st_ino;
+      bindings_attr_cache_put_since(r->b, cache, r->attr_gen, &ino, sizeof(ino), &stat, sizeof(stat), uv_hrtime() + (uint64_t) (r->b->attr_cache_ttl * 1e9));
+    }
+  }
+
+  r->result = used;
+}
+#endif
+
+// plain integers are stored in fh as is, anything else gets a file table slot and a generation
+// tagged with the thread owning the table
+static uint64_t bindings_fh_alloc (bindings_t *b, Local<Value> val) {
+  if (val->IsNumber()) {
+    double num = val->NumberValue();
+    if (num >= 0 && num < 9007199254740992.0 && num == (double) (uint64_t) num) return (uint64_t) num;
+  }
+
+  if (val->IsUndefined() || val->IsNull()) return 0;
+
+  if (b->files == NULL) b->files = new Nan::Persistent<Array>(Nan::New<Array>());
+
+  uint32_t slot;
+  if (b->files_free_length > 0) {
+    slot = b->files_free[--b->files_free_length];
+  } else {
+    if (b->files_length == b->files_alloc) {
+      b->files_alloc = b->files_alloc ? 2 * b->files_alloc : 64;
+      b->files_gen = (uint32_t *) realloc(b->files_gen, b->files_alloc * sizeof(uint32_t));
+      b->files_free = (uint32_t *) realloc(b->files_free, b->files_alloc * sizeof(uint32_t));
+    }
+    slot = b->files_length++;
+    b->files_gen[slot] = 0;
+  }
+
+  Nan::New(*(b->files))->Set(slot, val);
+  return BINDINGS_FH_SLOT | ((uint64_t) b->target_index << 55) | ((uint64_t) (b->files_gen[slot] & 0x7fffff) << 32) | slot;
+}
+
+static int bindings_fh_slot (bindings_t *b, uint64_t fh) {
+  uint32_t slot = (uint32_t) fh;
+  uint32_t gen = (uint32_t) (fh >> 32) & 0x7fffff;
+
+  if (BINDINGS_FH_TARGET(fh) != (uint32_t) b->target_index) return -1;
+  if (b->files == NULL || slot >= b->files_length || (b->files_gen[slot] & 0x7fffff) != gen) return -1;
+  return slot;
+}
+
+static Local<Value> bindings_fh_get (bindings_t *b, uint64_t fh) {
+  if (!(fh & BINDINGS_FH_SLOT)) return Nan::New<Number>(fh);
+
+  int slot = bindings_fh_slot(b, fh);
+  if (slot < 0) return Nan::Undefined();
+  return Nan::New(*(b->files))->Get(slot);
+}
+
+static void bindings_fh_free (bindings_t *b, uint64_t fh) {
+  if (!(fh & BINDINGS_FH_SLOT)) return;
+
+  int slot = bindings_fh_slot(b, fh);
+  if (slot < 0) return;
+
+  Nan::New(*(b->files))->Set(slot, Nan::Undefined());
+  b->files_gen[slot]++; // stale handles no longer resolve
+  b->files_free[b->files_free_length++] = slot;
+}
+
+// cb(0, fd, {keepCache, directIo, nonseekable}) from open, create and opendir
+static void bindings_set_open_flags (struct fuse_file_info *info, Local<Value> val) {
+  if (!val->IsObject()) return;
+  Local<Object> flags = val.As<Object>();
+
+  info->keep_cache = flags->Get(LOCAL_STRING("keepCache"))->BooleanValue() ? 1 : 0;
+  info->direct_io = flags->Get(LOCAL_STRING("directIo"))->BooleanValue() ? 1 : 0;
+  info->nonseekable = flags->Get(LOCAL_STRING("nonseekable"))->BooleanValue() ? 1 : 0;
+}
 
 NAN_METHOD(OpCallback) {
-  bindings_t *b = bindings_mounted[info[0]->Uint32Value()];
-  b->result = (info.Length() > 1 && info[1]->IsNumber()) ? info[1]->Uint32Value() : 0;
+  bindings_req_t *r = (bindings_req_t *) info[0].As<External>()->Value();
+  r->result = (info.Length() > 1 && info[1]->IsNumber()) ? info[1]->Uint32Value() : 0;
   bindings_current = NULL;
+
+  bindings_hist_record(&(bindings_op_stats(r->b, r->op)->handler), uv_hrtime() - r->time_dispatch);
+  if (r->b->attr_cache != NULL) bindings_attr_cache_invalidate(r);
+  if (r->b->xattr_cache != NULL) bindings_xattr_cache_invalidate(r);
+  if (r->b->negative_cache != NULL) bindings_negative_cache_invalidate(r);
+  if (r->b->read_cache != NULL) bindings_rc_invalidate(r);
+
+  // cb(bytes, fd, position) serves a read_buf straight from a file descriptor
+  if (r->read_fd != NULL && info.Length() > 2 && info[2]->IsNumber()) {
+    r->read_fd->fd = info[2]->Int32Value();
+    if (info.Length() > 3 && info[3]->IsNumber()) r->read_fd->position = info[3]->NumberValue();
+  }
   
-  if (!b->result) {
-    switch (b->op) {
+  if (!r->result) {
+    switch (r->op) {
       case OP_STATFS: {
-        if (info.Length() > 2 && info[2]->IsObject()) bindings_set_statfs((struct statvfs *) b->data, info[2].As<Object>());
+        if (info.Length() > 2 && info[2]->IsObject()) bindings_set_statfs((struct statvfs *) r->data, info[2].As<Object>());
       }
       break;
 
       case OP_GETATTR:
       case OP_FGETATTR: {
-        if (info.Length() > 2 && info[2]->IsObject()) bindings_set_stat((struct FUSE_STAT *) b->data, info[2].As<Object>());
+        if (!(info.Length() > 2 && info[2]->IsObject())) break;
+#ifndef _WIN32
+        if (r->b->lowlevel) {
+          struct fuse_entry_param *e = (struct fuse_entry_param *) r->data;
+          bindings_ll_set_entry(e, info[2].As<Object>(), info[3]);
+          if (r->b->attr_cache != NULL) bindings_attr_cache_put(r, &(e->attr), info[3]);
+          break;
+        }
+#endif
+        bindings_set_stat((struct FUSE_STAT *) r->data, info[2].As<Object>());
+        if (r->b->attr_cache != NULL && r->op == OP_GETATTR) bindings_attr_cache_put(r, (struct FUSE_STAT *) r->data, info[3]);
+      }
+      break;
+
+      case OP_LOOKUP:
+      case OP_MKNOD:
+      case OP_MKDIR:
+      case OP_LINK:
+      case OP_SYMLINK: {
+#ifndef _WIN32
+        if (r->b->lowlevel && info.Length() > 2 && info[2]->IsObject()) bindings_ll_set_entry((struct fuse_entry_param *) r->data, info[2].As<Object>(), info[3]);
+#endif
       }
       break;
 
       case OP_READDIR: {
-        if (info.Length() > 2 && info[2]->IsArray()) {
-          Local<Array> dirs = info[2].As<Array>();
-          
-          char **dirs_alloc = (char**)malloc(sizeof(char*)*dirs->Length());
-          
-          for (uint32_t i = 0; i < dirs->Length(); i++) {
-            
-            Nan::Utf8String dir(dirs->Get(i));
-            
-            dirs_alloc[i] = (char *) malloc(1024);
-            strcpy(dirs_alloc[i], *dir);
-          }
-          
-          Nan::AsyncQueueWorker(new SetDirWorker(b, dirs_alloc, dirs->Length()));
-          return;
+#ifndef _WIN32
+        if (r->b->lowlevel) {
+          if (info.Length() > 2 && info[2]->IsArray()) bindings_ll_set_dirs(r, info[2].As<Array>(), info[3]);
+          break;
         }
+#endif
+        if (info.Length() > 2 && info[2]->IsArray()) bindings_set_dirs((bindings_dir_t *) r->data, info[2].As<Array>(), info[3]);
       }
       break;
 
       case OP_CREATE:
+#ifndef _WIN32
+        if (r->b->lowlevel) {
+          // cb(0, stat, fd, flags, ttl), the fd and flags keep the places they have for open
+          if (info.Length() > 2 && info[2]->IsObject()) bindings_ll_set_entry((struct fuse_entry_param *) r->data, info[2].As<Object>(), info[5]);
+          if (info.Length() > 3) r->info->fh = bindings_fh_alloc(r->target, info[3]);
+          if (info.Length() > 4) bindings_set_open_flags(r->info, info[4]);
+          break;
+        }
+#endif
+
       case OP_OPEN:
       case OP_OPENDIR: {
-        if (info.Length() > 2 && info[2]->IsNumber()) {
-          b->info->fh = info[2].As<Number>()->Uint32Value();
-        }
+        if (info.Length() > 2) r->info->fh = bindings_fh_alloc(r->target, info[2]);
+        if (info.Length() > 3) bindings_set_open_flags(r->info, info[3]);
       }
       break;
 
       case OP_READLINK: {
         if (info.Length() > 2 && info[2]->IsString()) {
           Nan::Utf8String path(info[2]);
-          strcpy((char *) b->data, *path);
+          strncpy((char *) r->data, *path, r->length);
+          ((char *) r->data)[r->length - 1] = '\0';
         }
       }
       break;
@@ -874,7 +3698,6 @@ NAN_METHOD(OpCallback) {
       case OP_FTRUNCATE:
       case OP_CHOWN:
       case OP_CHMOD:
-      case OP_MKNOD:
       case OP_SETXATTR:
       case OP_GETXATTR:
       case OP_LISTXATTR:
@@ -886,334 +3709,525 @@ NAN_METHOD(OpCallback) {
       case OP_RELEASEDIR:
       case OP_UNLINK:
       case OP_RENAME:
-      case OP_LINK:
-      case OP_SYMLINK:
-      case OP_MKDIR:
       case OP_RMDIR:
       case OP_DESTROY:
+      case OP_FORGET:
       break;
     }
   }
 
-  semaphore_signal(&(b->semaphore));
+  bindings_req_done(r);
+}
+
+NAN_INLINE static void bindings_call_op (bindings_req_t *r, Nan::Callback *fn, int argc, Local<Value> *argv) {
+  if (fn == NULL) bindings_req_done(r);
+  else fn->Call(argc, argv);
+}
+
+static void bindings_path_cache_free (void *value, size_t value_size) {
+  Nan::Persistent<String> *str = *((Nan::Persistent<String> **) value);
+  str->Reset();
+  delete str;
+}
+
+// the same paths are dispatched over and over, so reuse their internalized strings
+static Local<String> bindings_string (bindings_t *b, const char *str) {
+  if (b->path_cache == NULL) return LOCAL_STRING(str);
+
+  size_t len = strlen(str);
+  Nan::Persistent<String> *cached;
+  size_t size = sizeof(cached);
+  if (cache_get(b->path_cache, str, len, &cached, &size)) return Nan::New(*cached);
+
+#if NODE_MODULE_VERSION >= NODE_4_0_MODULE_VERSION
+  Local<String> val = String::NewFromUtf8(Isolate::GetCurrent(), str, NewStringType::kInternalized, (int) len).ToLocalChecked();
+#else
+  Local<String> val = LOCAL_STRING(str);
+#endif
+
+  cached = new Nan::Persistent<String>(val);
+  cache_put(b->path_cache, str, len, &cached, sizeof(cached), 0);
+  return val;
 }
 
-NAN_INLINE static void bindings_call_op_ex (bindings_t *b, Nan::Callback *fn, int argc, Local<Value> *argv, bool isreaddir) {
-  if (fn == NULL){
-    if (isreaddir) {
-      semaphore_signal(&(b->semaphore_readdir));
-    } else {
-      semaphore_signal(&(b->semaphore));}  
-    } 
-  else {
-    fn->Call(argc, argv);
+static Local<Object> bindings_caps_object (uint32_t flags) {
+  Local<Object> caps = Nan::New<Object>();
+  for (int i = 0; bindings_caps[i].name != NULL; i++) {
+    caps->Set(LOCAL_STRING(bindings_caps[i].name), Nan::New<Boolean>((flags & bindings_caps[i].flag) != 0));
   }
+  return caps;
 }
 
-NAN_INLINE static void bindings_call_op (bindings_t *b, Nan::Callback *fn, int argc, Local<Value> *argv) {
-  bindings_call_op_ex(b, fn, argc, argv, false);
+static Local<Object> bindings_conn_object (struct fuse_conn_info *conn) {
+  Local<Object> obj = Nan::New<Object>();
+  obj->Set(LOCAL_STRING("protoMajor"), Nan::New<Number>(conn->proto_major));
+  obj->Set(LOCAL_STRING("protoMinor"), Nan::New<Number>(conn->proto_minor));
+  obj->Set(LOCAL_STRING("maxWrite"), Nan::New<Number>(conn->max_write));
+  obj->Set(LOCAL_STRING("maxReadahead"), Nan::New<Number>(conn->max_readahead));
+  obj->Set(LOCAL_STRING("capable"), bindings_caps_object(conn->capable));
+  obj->Set(LOCAL_STRING("want"), bindings_caps_object(conn->want));
+  return obj;
 }
 
-static void bindings_dispatch (uv_async_t* handle, int status) {
-  Nan::HandleScope scope;
-  
-  bindings_t *b = bindings_current = (bindings_t *) handle->data;
-  Local<Function> callback = b->callback->GetFunction();
-  b->result = -1;
+NAN_INLINE static Local<Value> bindings_path (bindings_req_t *r) {
+  if (r->b->lowlevel) return Nan::New<Number>((double) r->ino);
+  if (r->path == NULL) return Nan::Undefined();
+  return bindings_string(r->target, r->path);
+}
+
+#ifndef _WIN32
+static bool bindings_ll_dispatch_req (bindings_req_t *r, Local<Function> callback) {
+  bindings_t *b = r->target;
+  Local<Value> ino = Nan::New<Number>((double) r->ino);
+
+  switch (r->op) {
+    case OP_LOOKUP: {
+      Local<Value> tmp[] = {ino, bindings_string(b, r->name), callback};
+      bindings_call_op(r, b->ops_lookup, 3, tmp);
+    }
+    return true;
+
+    case OP_FORGET: {
+      Local<Value> tmp[] = {ino, Nan::New<Number>(r->length), callback};
+      bindings_call_op(r, b->ops_forget, 3, tmp);
+    }
+    return true;
+
+    case OP_READDIR: {
+      Local<Value> tmp[] = {ino, Nan::New<Number>(r->offset), callback};
+      bindings_call_op(r, b->ops_readdir, 3, tmp);
+    }
+    return true;
+
+    case OP_MKNOD: {
+      Local<Value> tmp[] = {ino, bindings_string(b, r->name), Nan::New<Number>(r->mode), Nan::New<Number>(r->dev), callback};
+      bindings_call_op(r, b->ops_mknod, 5, tmp);
+    }
+    return true;
+
+    case OP_MKDIR: {
+      Local<Value> tmp[] = {ino, bindings_string(b, r->name), Nan::New<Number>(r->mode), callback};
+      bindings_call_op(r, b->ops_mkdir, 4, tmp);
+    }
+    return true;
+
+    case OP_CREATE: {
+      Local<Value> tmp[] = {ino, bindings_string(b, r->name), Nan::New<Number>(r->mode), callback};
+      bindings_call_op(r, b->ops_create, 4, tmp);
+    }
+    return true;
+
+    case OP_UNLINK: {
+      Local<Value> tmp[] = {ino, bindings_string(b, r->name), callback};
+      bindings_call_op(r, b->ops_unlink, 3, tmp);
+    }
+    return true;
+
+    case OP_RMDIR: {
+      Local<Value> tmp[] = {ino, bindings_string(b, r->name), callback};
+      bindings_call_op(r, b->ops_rmdir, 3, tmp);
+    }
+    return true;
+
+    case OP_SYMLINK: {
+      Local<Value> tmp[] = {bindings_string(b, r->path), ino, bindings_string(b, r->name), callback};
+      bindings_call_op(r, b->ops_symlink, 4, tmp);
+    }
+    return true;
+
+    case OP_RENAME: {
+      Local<Value> tmp[] = {ino, bindings_string(b, r->name), Nan::New<Number>((double) r->length), bindings_string(b, (char *) r->data), callback};
+      bindings_call_op(r, b->ops_rename, 5, tmp);
+    }
+    return true;
+
+    case OP_LINK: {
+      Local<Value> tmp[] = {ino, Nan::New<Number>((double) r->length), bindings_string(b, r->name), callback};
+      bindings_call_op(r, b->ops_link, 4, tmp);
+    }
+    return true;
+
+    default:
+    return false;
+  }
+}
+#endif
+
+static void bindings_dispatch_req (bindings_req_t *r) {
+  bindings_t *b = r->target;
+  bindings_current = r;
+
+  r->time_dispatch = uv_hrtime();
+  atomic_add(&(r->b->queued), -1);
+  bindings_hist_record(&(bindings_op_stats(r->b, r->op)->queue), r->time_dispatch - r->time_call);
+
+  // requests are recycled across threads, so only the mount thread can keep its callback around
+  Local<Function> callback;
+  if (r->callback == NULL || b->parent != NULL) {
+    Local<Value> tmp[] = {Nan::New<External>(r), Nan::New<FunctionTemplate>(OpCallback)->GetFunction()};
+    Local<Function> fn = callback_constructor->Call(2, tmp).As<Function>();
+    if (b->parent != NULL) callback = fn;
+    else callback = (r->callback = new Nan::Callback(fn))->GetFunction();
+  } else {
+    callback = r->callback->GetFunction();
+  }
+
+  r->result = -1;
+
+  // a worker that dies leaves these unanswered, see bindings_worker_cleanup
+  if (b->parent != NULL) {
+    r->dispatched_next = b->dispatched;
+    r->dispatched_prev = &(b->dispatched);
+    if (b->dispatched != NULL) b->dispatched->dispatched_prev = &(r->dispatched_next);
+    b->dispatched = r;
+  }
 
-  switch (b->op) {
+#ifndef _WIN32
+  if (b->lowlevel && bindings_ll_dispatch_req(r, callback)) return;
+#endif
+
+  switch (r->op) {
     case OP_INIT: {
-      Local<Value> tmp[] = {callback};
-      bindings_call_op(b, b->ops_init, 1, tmp);
+      Local<Value> tmp[] = {bindings_conn_object((struct fuse_conn_info *) r->data), callback};
+      bindings_call_op(r, b->ops_init, 2, tmp);
     }
     return;
 
     case OP_ERROR: {
       Local<Value> tmp[] = {callback};
-      bindings_call_op(b, b->ops_error, 1, tmp);
+      bindings_call_op(r, b->ops_error, 1, tmp);
     }
     return;
 
     case OP_STATFS: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), callback};
-      bindings_call_op(b, b->ops_statfs, 2, tmp);
+      Local<Value> tmp[] = {bindings_path(r), callback};
+      bindings_call_op(r, b->ops_statfs, 2, tmp);
     }
     return;
 
     case OP_FGETATTR: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->info->fh), callback};
-      bindings_call_op(b, b->ops_fgetattr, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), bindings_fh_get(b, r->info->fh), callback};
+      bindings_call_op(r, b->ops_fgetattr, 3, tmp);
     }
     return;
 
     case OP_GETATTR: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), callback};
-      bindings_call_op(b, b->ops_getattr, 2, tmp);
+      Local<Value> tmp[] = {bindings_path(r), callback};
+      bindings_call_op(r, b->ops_getattr, 2, tmp);
     }
     return;
 
     case OP_READDIR: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), callback};
-      bindings_call_op_ex(b, b->ops_readdir, 2, tmp, true);
+      if (b->readdir_offset) {
+        Local<Value> tmp[] = {bindings_path(r), Nan::New<Number>(r->offset), callback};
+        bindings_call_op(r, b->ops_readdir, 3, tmp);
+      } else {
+        Local<Value> tmp[] = {bindings_path(r), callback};
+        bindings_call_op(r, b->ops_readdir, 2, tmp);
+      }
     }
     return;
 
     case OP_CREATE: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->mode), callback};
-      bindings_call_op(b, b->ops_create, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), Nan::New<Number>(r->mode), callback};
+      bindings_call_op(r, b->ops_create, 3, tmp);
     }
     return;
 
     case OP_TRUNCATE: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->length), callback};
-      bindings_call_op(b, b->ops_truncate, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), Nan::New<Number>(r->length), callback};
+      bindings_call_op(r, b->ops_truncate, 3, tmp);
     }
     return;
 
     case OP_FTRUNCATE: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->info->fh), Nan::New<Number>(b->length), callback};
-      bindings_call_op(b, b->ops_ftruncate, 4, tmp);
+      Local<Value> tmp[] = {bindings_path(r), bindings_fh_get(b, r->info->fh), Nan::New<Number>(r->length), callback};
+      bindings_call_op(r, b->ops_ftruncate, 4, tmp);
     }
     return;
 
     case OP_ACCESS: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->mode), callback};
-      bindings_call_op(b, b->ops_access, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), Nan::New<Number>(r->mode), callback};
+      bindings_call_op(r, b->ops_access, 3, tmp);
     }
     return;
 
     case OP_OPEN: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->mode), callback};
-      bindings_call_op(b, b->ops_open, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), Nan::New<Number>(r->mode), callback};
+      bindings_call_op(r, b->ops_open, 3, tmp);
     }
     return;
 
     case OP_OPENDIR: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->mode), callback};
-      bindings_call_op(b, b->ops_opendir, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), Nan::New<Number>(r->mode), callback};
+      bindings_call_op(r, b->ops_opendir, 3, tmp);
     }
     return;
 
     case OP_WRITE: {
       Local<Value> tmp[] = {
-        LOCAL_STRING(b->path),
-        Nan::New<Number>(b->info->fh),
-        bindings_buffer((char *) b->data, b->length),
-        Nan::New<Number>(b->length), // TODO: remove me
-        Nan::New<Number>(b->offset),
+        bindings_path(r),
+        bindings_fh_get(b, r->info->fh),
+        bindings_buffer((char *) r->data, r->length),
+        Nan::New<Number>(r->length), // TODO: remove me
+        Nan::New<Number>(r->offset),
         callback
       };
-      bindings_call_op(b, b->ops_write, 6, tmp);
+      bindings_call_op(r, b->ops_write, 6, tmp);
     }
     return;
 
     case OP_READ: {
       Local<Value> tmp[] = {
-        LOCAL_STRING(b->path),
-        Nan::New<Number>(b->info->fh),
-        bindings_buffer((char *) b->data, b->length),
-        Nan::New<Number>(b->length), // TODO: remove me
-        Nan::New<Number>(b->offset),
+        bindings_path(r),
+        bindings_fh_get(b, r->info->fh),
+        bindings_buffer((char *) r->data, r->length),
+        Nan::New<Number>(r->length), // TODO: remove me
+        Nan::New<Number>(r->offset),
         callback
       };
-      bindings_call_op(b, b->ops_read, 6, tmp);
+      bindings_call_op(r, b->ops_read, 6, tmp);
     }
     return;
 
     case OP_RELEASE: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->info->fh), callback};
-      bindings_call_op(b, b->ops_release, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), bindings_fh_get(b, r->info->fh), callback};
+      bindings_fh_free(b, r->info->fh);
+      bindings_call_op(r, b->ops_release, 3, tmp);
     }
     return;
 
     case OP_RELEASEDIR: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->info->fh), callback};
-      bindings_call_op(b, b->ops_releasedir, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), bindings_fh_get(b, r->info->fh), callback};
+      bindings_fh_free(b, r->info->fh);
+      bindings_call_op(r, b->ops_releasedir, 3, tmp);
     }
     return;
 
     case OP_UNLINK: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), callback};
-      bindings_call_op(b, b->ops_unlink, 2, tmp);
+      Local<Value> tmp[] = {bindings_path(r), callback};
+      bindings_call_op(r, b->ops_unlink, 2, tmp);
     }
     return;
 
     case OP_RENAME: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), LOCAL_STRING((char *) b->data), callback};
-      bindings_call_op(b, b->ops_rename, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), bindings_string(b, (char *) r->data), callback};
+      bindings_call_op(r, b->ops_rename, 3, tmp);
     }
     return;
 
     case OP_LINK: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), LOCAL_STRING((char *) b->data), callback};
-      bindings_call_op(b, b->ops_link, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), bindings_string(b, (char *) r->data), callback};
+      bindings_call_op(r, b->ops_link, 3, tmp);
     }
     return;
 
     case OP_SYMLINK: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), LOCAL_STRING((char *) b->data), callback};
-      bindings_call_op(b, b->ops_symlink, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), bindings_string(b, (char *) r->data), callback};
+      bindings_call_op(r, b->ops_symlink, 3, tmp);
     }
     return;
 
     case OP_CHMOD: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->mode), callback};
-      bindings_call_op(b, b->ops_chmod, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), Nan::New<Number>(r->mode), callback};
+      bindings_call_op(r, b->ops_chmod, 3, tmp);
     }
     return;
 
     case OP_MKNOD: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->mode), Nan::New<Number>(b->dev), callback};
-      bindings_call_op(b, b->ops_mknod, 4, tmp);
+      Local<Value> tmp[] = {bindings_path(r), Nan::New<Number>(r->mode), Nan::New<Number>(r->dev), callback};
+      bindings_call_op(r, b->ops_mknod, 4, tmp);
     }
     return;
 
     case OP_CHOWN: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->uid), Nan::New<Number>(b->gid), callback};
-      bindings_call_op(b, b->ops_chown, 4, tmp);
+      Local<Value> tmp[] = {bindings_path(r), Nan::New<Number>(r->uid), Nan::New<Number>(r->gid), callback};
+      bindings_call_op(r, b->ops_chown, 4, tmp);
     }
     return;
 
     case OP_READLINK: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), callback};
-      bindings_call_op(b, b->ops_readlink, 2, tmp);
+      Local<Value> tmp[] = {bindings_path(r), callback};
+      bindings_call_op(r, b->ops_readlink, 2, tmp);
     }
     return;
 
     case OP_SETXATTR: {
       Local<Value> tmp[] = {
-        LOCAL_STRING(b->path),
-        LOCAL_STRING(b->name),
-        bindings_buffer((char *) b->data, b->length),
-        Nan::New<Number>(b->length),
-        Nan::New<Number>(b->offset),
-        Nan::New<Number>(b->mode),
+        bindings_path(r),
+        bindings_string(b, r->name),
+        bindings_buffer((char *) r->data, r->length),
+        Nan::New<Number>(r->length),
+        Nan::New<Number>(r->offset),
+        Nan::New<Number>(r->mode),
         callback
       };
-      bindings_call_op(b, b->ops_setxattr, 7, tmp);
+      bindings_call_op(r, b->ops_setxattr, 7, tmp);
     }
     return;
 
     case OP_GETXATTR: {
       Local<Value> tmp[] = {
-        LOCAL_STRING(b->path),
-        LOCAL_STRING(b->name),
-        bindings_buffer((char *) b->data, b->length),
-        Nan::New<Number>(b->length),
-        Nan::New<Number>(b->offset),
+        bindings_path(r),
+        bindings_string(b, r->name),
+        bindings_buffer((char *) r->data, r->length),
+        Nan::New<Number>(r->length),
+        Nan::New<Number>(r->offset),
         callback
       };
-      bindings_call_op(b, b->ops_getxattr, 6, tmp);
+      bindings_call_op(r, b->ops_getxattr, 6, tmp);
     }
     return;
 
     case OP_LISTXATTR: {
       Local<Value> tmp[] = {
-        LOCAL_STRING(b->path),
-        bindings_buffer((char *) b->data, b->length),
-        Nan::New<Number>(b->length),
+        bindings_path(r),
+        bindings_buffer((char *) r->data, r->length),
+        Nan::New<Number>(r->length),
         callback
       };
-      bindings_call_op(b, b->ops_listxattr, 4, tmp);
+      bindings_call_op(r, b->ops_listxattr, 4, tmp);
     }
     return;
 
     case OP_REMOVEXATTR: {
       Local<Value> tmp[] = {
-        LOCAL_STRING(b->path),
-        LOCAL_STRING(b->name),
+        bindings_path(r),
+        bindings_string(b, r->name),
         callback
       };
-      bindings_call_op(b, b->ops_removexattr, 3, tmp);
+      bindings_call_op(r, b->ops_removexattr, 3, tmp);
     }
     return;
 
     case OP_MKDIR: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->mode), callback};
-      bindings_call_op(b, b->ops_mkdir, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), Nan::New<Number>(r->mode), callback};
+      bindings_call_op(r, b->ops_mkdir, 3, tmp);
     }
     return;
 
     case OP_RMDIR: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), callback};
-      bindings_call_op(b, b->ops_rmdir, 2, tmp);
+      Local<Value> tmp[] = {bindings_path(r), callback};
+      bindings_call_op(r, b->ops_rmdir, 2, tmp);
     }
     return;
 
     case OP_DESTROY: {
       Local<Value> tmp[] = {callback};
-      bindings_call_op(b, b->ops_destroy, 1, tmp);
+      bindings_call_op(r, b->ops_destroy, 1, tmp);
     }
     return;
 
     case OP_UTIMENS: {
-      struct timespec *tv = (struct timespec *) b->data;
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), bindings_get_date(tv), bindings_get_date(tv + 1), callback};
-      bindings_call_op(b, b->ops_utimens, 4, tmp);
+      struct timespec *tv = (struct timespec *) r->data;
+      Local<Value> tmp[] = {bindings_path(r), bindings_get_date(tv), bindings_get_date(tv + 1), callback};
+      bindings_call_op(r, b->ops_utimens, 4, tmp);
     }
     return;
 
     case OP_FLUSH: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->info->fh), callback};
-      bindings_call_op(b, b->ops_flush, 3, tmp);
+      Local<Value> tmp[] = {bindings_path(r), bindings_fh_get(b, r->info->fh), callback};
+      bindings_call_op(r, b->ops_flush, 3, tmp);
     }
     return;
 
     case OP_FSYNC: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->info->fh), Nan::New<Number>(b->mode), callback};
-      bindings_call_op(b, b->ops_fsync, 4, tmp);
+      Local<Value> tmp[] = {bindings_path(r), bindings_fh_get(b, r->info->fh), Nan::New<Number>(r->mode), callback};
+      bindings_call_op(r, b->ops_fsync, 4, tmp);
     }
     return;
 
     case OP_FSYNCDIR: {
-      Local<Value> tmp[] = {LOCAL_STRING(b->path), Nan::New<Number>(b->info->fh), Nan::New<Number>(b->mode), callback};
-      bindings_call_op(b, b->ops_fsyncdir, 4, tmp);
+      Local<Value> tmp[] = {bindings_path(r), bindings_fh_get(b, r->info->fh), Nan::New<Number>(r->mode), callback};
+      bindings_call_op(r, b->ops_fsyncdir, 4, tmp);
     }
     return;
+
+    case OP_LOOKUP:
+    case OP_FORGET:
+    break; // only used in lowlevel mode
   }
 
-  semaphore_signal(&(b->semaphore));
+  bindings_req_done(r);
 }
 
-static int bindings_alloc () {
-  int free_index = -1;
-  size_t size = sizeof(bindings_t);
+static void bindings_req_fail (bindings_req_t *r) {
+  atomic_add(&(r->b->queued), -1);
+  r->result = -EIO;
+  bindings_req_done(r);
+}
 
-  for (int i = 0; i < bindings_mounted_count; i++) {
-    if (bindings_mounted[i] == NULL) {
-      free_index = i;
-      break;
-    }
-  }
+// runs on a worker thread that is exiting without the mount being closed, it terminated or threw.
+// t stays around detached so fuse threads can still queue to it, the mount thread fails those requests
+static void bindings_worker_cleanup (void *data) {
+  bindings_t *t = (bindings_t *) data;
+  bindings_t *b = t->parent;
 
-  if (free_index == -1 && bindings_mounted_count < 1024) free_index = bindings_mounted_count++;
-  if (free_index != -1) {
-    bindings_t *b = bindings_mounted[free_index] = (bindings_t *) malloc(size);
-    memset(b, 0, size);
-    b->index = free_index;
+  while (t->dispatched != NULL) {
+    bindings_req_t *r = t->dispatched;
+    r->result = -EIO;
+    bindings_req_done(r);
   }
 
-  return free_index;
+  atomic_add(&(t->detached), 1);
+  while (atomic_get(&(t->senders)) > 0) thread_yield();
+
+  uv_close((uv_handle_t*) &(t->async), NULL);
+  bindings_free_js(t);
+
+  uv_async_send(&(b->async));
+  semaphore_signal(&(b->workers_closed));
 }
 
-NAN_METHOD(Mount) {
-  if (!info[0]->IsString()) return Nan::ThrowError("mnt must be a string");
+static void bindings_dispatch (uv_async_t* handle, int status) {
+  Nan::HandleScope scope;
 
-  mutex_lock(&mutex);
-  int index = bindings_alloc();
-  mutex_unlock(&mutex);
+  bindings_t *b = (bindings_t *) handle->data;
+  bindings_req_t *r;
+
+  // wakeups coalesce, so drain everything that was queued since the last one
+  while ((r = bindings_ring_shift(b)) != NULL) bindings_dispatch_req(r);
+
+  // the queues of dead workers are owned by the mount thread
+  for (uint32_t i = 0; i < b->workers_length; i++) {
+    bindings_t *t = b->workers[i];
+    if (t == NULL || !atomic_get(&(t->detached))) continue;
+    while ((r = bindings_ring_shift(t)) != NULL) bindings_req_fail(r);
+  }
+
+  if (b->parent != NULL && atomic_get(&(b->parent->closing))) {
+#if NODE_MODULE_VERSION >= NODE_10_0_MODULE_VERSION
+    node::RemoveEnvironmentCleanupHook(Isolate::GetCurrent(), bindings_worker_cleanup, b);
+#endif
+    uv_close((uv_handle_t*) handle, &bindings_on_worker_close);
+  }
+}
+
+static bindings_t *bindings_alloc (const char *mnt) {
+  bindings_t *b = (bindings_t *) calloc(1, sizeof(bindings_t));
+  b->mnt = strdup(mnt);
+  b->mntopts = strdup("-o");
+  return b;
+}
 
-  if (index == -1) return Nan::ThrowError("You cannot mount more than 1024 filesystem in one process");
+static void bindings_mntopts_add (bindings_t *b, const char *opt) {
+  b->mntopts = (char *) realloc(b->mntopts, strlen(b->mntopts) + strlen(opt) + 2);
+  if (strcmp(b->mntopts, "-o")) strcat(b->mntopts, ",");
+  strcat(b->mntopts, opt);
+}
+
+static bindings_t *bindings_find_mounted_value (Local<Value> val) {
+  if (!val->IsString()) return NULL;
+  Nan::Utf8String mnt(val);
 
   mutex_lock(&mutex);
-  bindings_t *b = bindings_mounted[index];
+  bindings_t *b = bindings_find_mounted(*mnt);
   mutex_unlock(&mutex);
 
-  memset(&empty_stat, 0, sizeof(empty_stat));
-
-  Nan::Utf8String path(info[0]);
-  Local<Object> ops = info[1].As<Object>();
+  return b;
+}
 
+static void bindings_lookup_ops (bindings_t *b, Local<Object> ops) {
   b->ops_init = LOOKUP_CALLBACK(ops, "init");
   b->ops_error = LOOKUP_CALLBACK(ops, "error");
   b->ops_access = LOOKUP_CALLBACK(ops, "access");
@@ -1249,28 +4263,373 @@ NAN_METHOD(Mount) {
   b->ops_mkdir = LOOKUP_CALLBACK(ops, "mkdir");
   b->ops_rmdir = LOOKUP_CALLBACK(ops, "rmdir");
   b->ops_destroy = LOOKUP_CALLBACK(ops, "destroy");
+  b->ops_lookup = LOOKUP_CALLBACK(ops, "lookup");
+  b->ops_forget = LOOKUP_CALLBACK(ops, "forget");
+}
+
+static cache_t *bindings_path_cache_alloc (size_t max_size) {
+  cache_t *cache = (cache_t *) malloc(sizeof(cache_t));
+  cache_init(cache, max_size, bindings_path_cache_free);
+  return cache;
+}
+
+// a rule is a glob string or {prefix}, returns false when removing a rule that was not there
+static bool bindings_negative_rule (bindings_t *b, Local<Value> rule, bool add) {
+  int prefix = 0;
+
+  if (rule->IsObject() && !rule->IsString()) {
+    rule = rule.As<Object>()->Get(LOCAL_STRING("prefix"));
+    prefix = 1;
+  }
+  if (!rule->IsString()) return false;
+
+  Nan::Utf8String str(rule);
+  if (!add) return matcher_remove(b->negative_rules, *str, prefix);
+
+  matcher_add(b->negative_rules, *str, prefix);
+  return true;
+}
+
+static void bindings_xattr_rule_add (bindings_t *b, const char *name, Local<Value> val) {
+  bindings_xattr_rule_t rule = { };
+
+  if (val->IsTrue()) {
+    rule.pass = 1;
+  } else if (val->IsNumber()) {
+    rule.result = val->Int32Value();
+  } else if (node::Buffer::HasInstance(val)) {
+    rule.value_length = node::Buffer::Length(val);
+    rule.value = (char *) malloc(rule.value_length + 1);
+    memcpy(rule.value, node::Buffer::Data(val), rule.value_length);
+  } else if (val->IsString()) {
+    Nan::Utf8String str(val);
+    rule.value_length = str.length();
+    rule.value = strdup(*str);
+  } else {
+    return;
+  }
+
+  rule.name = strdup(name);
+  rule.length = strlen(name);
+  if (rule.length > 0 && name[rule.length - 1] == '*') {
+    rule.prefix = 1;
+    rule.length--;
+  }
+
+  b->xattr_rules = (bindings_xattr_rule_t *) realloc(b->xattr_rules, (b->xattr_rules_length + 1) * sizeof(bindings_xattr_rule_t));
+  b->xattr_rules[b->xattr_rules_length++] = rule;
+}
+
+// true answers the usual security and acl probes with "no such attribute"
+static void bindings_xattr_policy (bindings_t *b, Local<Value> policy) {
+  if (!policy->IsObject()) {
+    Local<Value> missing = Nan::New<Number>(-BINDINGS_ENOATTR);
+    bindings_xattr_rule_add(b, "security.*", missing);
+    bindings_xattr_rule_add(b, "system.posix_acl_access", missing);
+    bindings_xattr_rule_add(b, "system.posix_acl_default", missing);
+    return;
+  }
+
+  Local<Array> names = Nan::GetOwnPropertyNames(policy.As<Object>()).ToLocalChecked();
+  for (uint32_t i = 0; i < names->Length(); i++) {
+    Local<Value> name = names->Get(i);
+    bindings_xattr_rule_add(b, *Nan::Utf8String(name), policy.As<Object>()->Get(name));
+  }
+}
+
+static double bindings_mount_timeout (bindings_t *b, Local<Object> ops, const char *name, const char *opt, double def) {
+  Local<Value> val = ops->Get(LOCAL_STRING(name));
+  if (!val->IsNumber()) return def;
+
+  double timeout = val->NumberValue();
 
-  Local<Value> tmp[] = {Nan::New<Number>(index), Nan::New<FunctionTemplate>(OpCallback)->GetFunction()};
-  b->callback = new Nan::Callback(callback_constructor->Call(2, tmp).As<Function>());
+  // the high level api applies these itself, lowlevel replies carry them per entry
+  if (!b->lowlevel) {
+    char tmp[64];
+    sprintf(tmp, "%s=%g", opt, timeout);
+    bindings_mntopts_add(b, tmp);
+  }
+
+  return timeout;
+}
+
+NAN_METHOD(Mount) {
+  if (!info[0]->IsString()) return Nan::ThrowError("mnt must be a string");
+
+#ifdef _WIN32
+  if (info[1].As<Object>()->Get(LOCAL_STRING("lowlevel"))->BooleanValue()) return Nan::ThrowError("lowlevel mode is not supported on Windows");
+#endif
+
+  Nan::Utf8String path(info[0]);
+  Local<Object> ops = info[1].As<Object>();
+  bindings_t *b = bindings_alloc(*path);
+
+  bindings_lookup_ops(b, ops);
+
+  b->multithreaded = ops->Get(LOCAL_STRING("multithreaded"))->BooleanValue();
+  b->lowlevel = ops->Get(LOCAL_STRING("lowlevel"))->BooleanValue();
+  b->readdir_offset = ops->Get(LOCAL_STRING("readdirOffset"))->BooleanValue();
+  b->zero_copy = ops->Get(LOCAL_STRING("zeroCopy"))->BooleanValue();
+#ifndef _WIN32
+  b->null_path = !b->lowlevel && ops->Get(LOCAL_STRING("nullPath"))->BooleanValue();
+#endif
+
+#ifdef __linux__
+  // fuse_loop_mt spawns its own threads, so multithreaded mounts keep their own loop
+  Local<Value> shared = ops->Get(LOCAL_STRING("sharedDriver"));
+  if (shared->BooleanValue() && !b->multithreaded) b->shared = shared->IsNumber() ? shared->Uint32Value() : 4;
+#endif
 
-  strcpy(b->mnt, *path);
-  strcpy(b->mntopts, "-o");
+  Local<Value> max_write = ops->Get(LOCAL_STRING("maxWrite"));
+  if (max_write->IsNumber()) b->max_write = max_write->Uint32Value();
+  Local<Value> max_readahead = ops->Get(LOCAL_STRING("maxReadahead"));
+  if (max_readahead->IsNumber()) b->max_readahead = max_readahead->Uint32Value();
+
+  // true asks for a capability, false turns off one the kernel enables by default
+  for (int i = 0; bindings_caps[i].name != NULL; i++) {
+    Local<Value> want = ops->Get(LOCAL_STRING(bindings_caps[i].name));
+    if (want->IsBoolean()) {
+      if (want->BooleanValue()) b->conn_want |= bindings_caps[i].flag;
+      else b->conn_unwant |= bindings_caps[i].flag;
+    }
+  }
 
   Local<Array> options = ops->Get(LOCAL_STRING("options")).As<Array>();
   if (options->IsArray()) {
     for (uint32_t i = 0; i < options->Length(); i++) {
       Nan::Utf8String option(options->Get(i));
-      if (strcmp(b->mntopts, "-o")) strcat(b->mntopts, ",");
-      strcat(b->mntopts, *option);
+      bindings_mntopts_add(b, *option);
+    }
+  }
+
+  b->attr_timeout = bindings_mount_timeout(b, ops, "attrTimeout", "attr_timeout", 1.0);
+  b->entry_timeout = bindings_mount_timeout(b, ops, "entryTimeout", "entry_timeout", 1.0);
+  b->negative_timeout = bindings_mount_timeout(b, ops, "negativeTimeout", "negative_timeout", 0.0);
+
+  Local<Value> path_cache = ops->Get(LOCAL_STRING("pathCache"));
+  if (path_cache->BooleanValue()) {
+    b->path_cache = bindings_path_cache_alloc(path_cache->IsNumber() ? path_cache->NumberValue() : 1024 * 1024);
+  }
+
+  Local<Value> attr_cache = ops->Get(LOCAL_STRING("attrCache"));
+  if (attr_cache->BooleanValue()) {
+    double max_size = 16 * 1024 * 1024;
+    b->attr_cache_ttl = b->attr_timeout;
+
+    if (attr_cache->IsObject()) {
+      Local<Value> val = attr_cache.As<Object>()->Get(LOCAL_STRING("maxSize"));
+      if (val->IsNumber()) max_size = val->NumberValue();
+      val = attr_cache.As<Object>()->Get(LOCAL_STRING("ttl"));
+      if (val->IsNumber()) b->attr_cache_ttl = val->NumberValue();
+    }
+
+    b->attr_cache = (cache_t *) malloc(sizeof(cache_t));
+    cache_init(b->attr_cache, (size_t) max_size, NULL);
+  }
+
+  b->negative_rules = (matcher_t *) malloc(sizeof(matcher_t));
+  matcher_init(b->negative_rules);
+
+  Local<Value> negative_rules = ops->Get(LOCAL_STRING("negativeRules"));
+  if (negative_rules->IsArray()) {
+    for (uint32_t i = 0; i < negative_rules.As<Array>()->Length(); i++) {
+      bindings_negative_rule(b, negative_rules.As<Array>()->Get(i), true);
+    }
+  }
+
+  // lowlevel lookups are cached by the kernel with ops.negativeTimeout instead
+  Local<Value> negative_cache = ops->Get(LOCAL_STRING("negativeCache"));
+  if (!b->lowlevel && negative_cache->BooleanValue()) {
+    double max_size = 4 * 1024 * 1024;
+    b->negative_cache_ttl = 1;
+
+    if (negative_cache->IsObject()) {
+      Local<Value> val = negative_cache.As<Object>()->Get(LOCAL_STRING("maxSize"));
+      if (val->IsNumber()) max_size = val->NumberValue();
+      val = negative_cache.As<Object>()->Get(LOCAL_STRING("ttl"));
+      if (val->IsNumber()) b->negative_cache_ttl = val->NumberValue();
+    }
+
+    b->negative_cache = (cache_t *) malloc(sizeof(cache_t));
+    cache_init(b->negative_cache, (size_t) max_size, NULL);
+  }
+
+  Local<Value> xattr_policy = ops->Get(LOCAL_STRING("xattrPolicy"));
+  if (xattr_policy->BooleanValue()) bindings_xattr_policy(b, xattr_policy);
+
+  // keyed by path, index.js refuses it for lowlevel mounts
+
+  Local<Value> xattr_cache = ops->Get(LOCAL_STRING("xattrCache"));
+  if (!b->lowlevel && xattr_cache->BooleanValue()) {
+    double max_size = 4 * 1024 * 1024;
+    b->xattr_cache_ttl = b->attr_timeout;
+
+    if (xattr_cache->IsObject()) {
+      Local<Value> val = xattr_cache.As<Object>()->Get(LOCAL_STRING("maxSize"));
+      if (val->IsNumber()) max_size = val->NumberValue();
+      val = xattr_cache.As<Object>()->Get(LOCAL_STRING("ttl"));
+      if (val->IsNumber()) b->xattr_cache_ttl = val->NumberValue();
+    }
+
+    b->xattr_cache = (cache_t *) malloc(sizeof(cache_t));
+    cache_init(b->xattr_cache, (size_t) max_size, NULL);
+  }
+
+  Local<Value> write_buffer = ops->Get(LOCAL_STRING("writeBuffer"));
+  if (write_buffer->BooleanValue()) {
+    double max_size = 1024 * 1024;
+    double max_delay = 1;
+
+    if (write_buffer->IsObject()) {
+      Local<Value> val = write_buffer.As<Object>()->Get(LOCAL_STRING("maxSize"));
+      if (val->IsNumber() && val->NumberValue() >= 1) max_size = val->NumberValue();
+      val = write_buffer.As<Object>()->Get(LOCAL_STRING("maxDelay"));
+      if (val->IsNumber()) max_delay = val->NumberValue();
+    }
+
+    b->write_buffer_size = (uint32_t) max_size;
+    b->write_buffer_delay = (uint64_t) (max_delay * 1e9);
+    mutex_init(&(b->wb_lock));
+  }
+
+  Local<Value> read_cache = ops->Get(LOCAL_STRING("readCache"));
+  if (read_cache->BooleanValue()) {
+    double max_size = 64 * 1024 * 1024;
+    double block_size = 128 * 1024;
+    double read_ahead = 1024 * 1024;
+
+    if (read_cache->IsObject()) {
+      Local<Value> val = read_cache.As<Object>()->Get(LOCAL_STRING("maxSize"));
+      if (val->IsNumber()) max_size = val->NumberValue();
+      val = read_cache.As<Object>()->Get(LOCAL_STRING("blockSize"));
+      if (val->IsNumber() && val->NumberValue() >= 4096) block_size = val->NumberValue();
+      val = read_cache.As<Object>()->Get(LOCAL_STRING("readahead"));
+      if (val->IsNumber()) read_ahead = val->NumberValue();
+    }
+
+    b->read_block_size = (uint32_t) block_size;
+    b->read_ahead = (uint32_t) (read_ahead / block_size);
+    b->read_cache = (cache_t *) malloc(sizeof(cache_t));
+    b->read_state = (cache_t *) malloc(sizeof(cache_t));
+    cache_init(b->read_cache, (size_t) max_size, NULL);
+    cache_init(b->read_state, 1024 * 1024, NULL);
+    mutex_init(&(b->rc_lock));
+  }
+
+  Local<Value> async_release = ops->Get(LOCAL_STRING("asyncRelease"));
+  if (async_release->BooleanValue()) {
+    b->deferred_max = BINDINGS_DEFERRED_MAX;
+
+    if (async_release->IsObject()) {
+      Local<Value> val = async_release.As<Object>()->Get(LOCAL_STRING("maxQueue"));
+      if (val->IsNumber() && val->Uint32Value() > 0 && val->Uint32Value() < BINDINGS_DEFERRED_MAX) b->deferred_max = val->Uint32Value();
+      b->deferred_flush = async_release.As<Object>()->Get(LOCAL_STRING("flush"))->BooleanValue();
     }
   }
 
-  semaphore_init(&(b->semaphore));
-  semaphore_init(&(b->semaphore_readdir));
+  mutex_init(&(b->lock));
+  bindings_ring_init(b);
+  b->stats = (bindings_op_stats_t **) calloc(BINDINGS_OPS_LENGTH, sizeof(bindings_op_stats_t *));
   uv_async_init(uv_default_loop(), &(b->async), (uv_async_cb) bindings_dispatch);
   b->async.data = b;
 
-  thread_create(&(b->thread), bindings_thread, b);
+  Local<Value> workers = ops->Get(LOCAL_STRING("workers"));
+  if (workers->IsNumber() && workers->Uint32Value() > 0) {
+    b->workers_length = workers->Uint32Value();
+    if (b->workers_length > BINDINGS_MAX_WORKERS) b->workers_length = BINDINGS_MAX_WORKERS;
+    b->workers = (bindings_t **) calloc(b->workers_length, sizeof(bindings_t *));
+    b->workers_affinity = !strcmp(*Nan::Utf8String(ops->Get(LOCAL_STRING("workerRouting"))), "affinity");
+    semaphore_init(&(b->workers_closed));
+  }
+
+  mutex_lock(&mutex);
+  bindings_registry_add(b);
+  mutex_unlock(&mutex);
+
+  // with workers the session is started once all of them have attached
+  if (b->workers_length == 0) bindings_start(b);
+}
+
+// attach(mnt, index, ops), called from a worker thread to become workers[index] of a mount
+NAN_METHOD(Attach) {
+  bindings_t *b = bindings_find_mounted_value(info[0]);
+  if (b == NULL) return Nan::ThrowError("Mount not found");
+
+  uint32_t index = info[1]->Uint32Value();
+  if (index >= b->workers_length) return Nan::ThrowError("Invalid worker index");
+
+  // the slot is held under the lock as detach might be giving up on this worker at the same time
+  mutex_lock(&(b->lock));
+  if (b->workers[index] != NULL) {
+    mutex_unlock(&(b->lock));
+    return Nan::ThrowError("Invalid worker index");
+  }
+
+  bindings_t *t = (bindings_t *) calloc(1, sizeof(bindings_t));
+  t->parent = b;
+  t->target_index = index + 1;
+  t->lowlevel = b->lowlevel;
+  t->readdir_offset = b->readdir_offset;
+  t->zero_copy = b->zero_copy;
+  t->attr_timeout = b->attr_timeout;
+  t->entry_timeout = b->entry_timeout;
+  t->negative_timeout = b->negative_timeout;
+  t->attr_cache = b->attr_cache;
+  t->attr_cache_ttl = b->attr_cache_ttl;
+  t->stats = b->stats;
+  t->read_cache = b->read_cache;
+  t->read_state = b->read_state;
+  t->read_block_size = b->read_block_size;
+  t->read_ahead = b->read_ahead;
+  t->mnt = strdup(b->mnt);
+
+  bindings_lookup_ops(t, info[2].As<Object>());
+  if (b->path_cache != NULL) t->path_cache = bindings_path_cache_alloc(b->path_cache->max_size);
+
+  mutex_init(&(t->lock));
+  bindings_ring_init(t);
+  uv_async_init(Nan::GetCurrentEventLoop(), &(t->async), (uv_async_cb) bindings_dispatch);
+  t->async.data = t;
+
+  b->workers[index] = t;
+  mutex_unlock(&(b->lock));
+
+#if NODE_MODULE_VERSION >= NODE_10_0_MODULE_VERSION
+  node::AddEnvironmentCleanupHook(Isolate::GetCurrent(), bindings_worker_cleanup, t);
+#endif
+
+  if (atomic_add(&(b->workers_attached), 1) == b->workers_length) bindings_start(b);
+}
+
+// detach(mnt, index), called on the mount thread when a worker exits.
+// returns true if the mount was still in use and should be unmounted
+NAN_METHOD(Detach) {
+  bindings_t *b = bindings_find_mounted_value(info[0]);
+  uint32_t index = info[1]->Uint32Value();
+  if (b == NULL || index >= b->workers_length || atomic_get(&(b->closing))) return info.GetReturnValue().Set(false);
+
+  // a worker that never attached gets a stand in, so the mount can start and fail its requests
+  bindings_t *t = (bindings_t *) calloc(1, sizeof(bindings_t));
+  t->parent = b;
+  t->target_index = index + 1;
+  t->detached = 1;
+  t->mnt = strdup(b->mnt);
+  mutex_init(&(t->lock));
+  bindings_ring_init(t);
+
+  mutex_lock(&(b->lock));
+  int taken = b->workers[index] != NULL;
+  if (!taken) b->workers[index] = t;
+  mutex_unlock(&(b->lock));
+
+  if (taken) {
+    bindings_free(t);
+  } else {
+    semaphore_signal(&(b->workers_closed));
+    if (atomic_add(&(b->workers_attached), 1) == b->workers_length) bindings_start(b);
+  }
+
+  info.GetReturnValue().Set(true);
 }
 
 class UnmountWorker : public Nan::AsyncWorker {
@@ -1298,12 +4657,207 @@ class UnmountWorker : public Nan::AsyncWorker {
   int result;
 };
 
+class UnmountManyWorker : public Nan::AsyncWorker {
+ public:
+  UnmountManyWorker(Nan::Callback *callback, char **paths, uint32_t length)
+    : Nan::AsyncWorker(callback), paths(paths), length(length) {
+    unmounts = (bindings_unmount_t *) calloc(length, sizeof(bindings_unmount_t));
+  }
+  ~UnmountManyWorker() {
+    for (uint32_t i = 0; i < length; i++) free(paths[i]);
+    free(paths);
+    free(unmounts);
+  }
+
+  // the unmounts are started in parallel and the sessions wind down on their own threads meanwhile
+  void Execute () {
+    bindings_unmount_batch_t batch = {paths, unmounts, length, 0};
+    uint32_t threads = length < BINDINGS_UNMOUNT_THREADS ? length : BINDINGS_UNMOUNT_THREADS;
+    abstr_thread_t pool[BINDINGS_UNMOUNT_THREADS];
+
+    for (uint32_t i = 0; i < threads; i++) thread_create(pool + i, bindings_unmount_batch_thread, &batch);
+    for (uint32_t i = 0; i < threads; i++) thread_join(pool[i]);
+    for (uint32_t i = 0; i < length; i++) bindings_unmount_finish(unmounts + i);
+  }
+
+  void HandleOKCallback () {
+    Nan::HandleScope scope;
+    Local<Array> results = Nan::New<Array>(length);
+    for (uint32_t i = 0; i < length; i++) results->Set(i, Nan::New<Number>(unmounts[i].result));
+    Local<Value> argv[] = {Nan::Null(), results};
+    callback->Call(2, argv);
+  }
+
+ private:
+  char **paths;
+  uint32_t length;
+  bindings_unmount_t *unmounts;
+};
+
+#ifndef _WIN32
+// notifications write to the fuse device and can block on kernel locks, so they are sent off the loop
+class NotifyWorker : public Nan::AsyncWorker {
+ public:
+  NotifyWorker(Nan::Callback *callback, const char *mnt, uint64_t ino, FUSE_OFF_T offset, FUSE_OFF_T length, const char *name)
+    : Nan::AsyncWorker(callback), ino(ino), offset(offset), length(length), data(NULL), result(0) {
+    this->mnt = strdup(mnt);
+    this->name = name != NULL ? strdup(name) : NULL;
+  }
+  ~NotifyWorker() {
+    free(mnt);
+    free(name);
+    free(data);
+  }
+
+  // turns the notification into a store of length bytes at offset
+  void SetData (const char *buf) {
+    data = (char *) malloc(length);
+    memcpy(data, buf, length);
+  }
+
+  // the kernel can block a notification on locks held by requests that wait for js, so it is sent unlocked
+  void Execute () {
+    mutex_lock(&mutex);
+    bindings_t *b = bindings_pin(mnt);
+    struct fuse_chan *ch = b != NULL ? b->ch : NULL;
+    mutex_unlock(&mutex);
+
+    if (ch != NULL) {
+      if (data != NULL) {
+        struct fuse_bufvec bufv = FUSE_BUFVEC_INIT((size_t) length);
+        bufv.buf[0].mem = data;
+        result = fuse_lowlevel_notify_store(ch, ino, offset, &bufv, (enum fuse_buf_copy_flags) 0);
+      } else if (name != NULL) {
+        result = fuse_lowlevel_notify_inval_entry(ch, ino, name, strlen(name));
+      } else {
+        result = fuse_lowlevel_notify_inval_inode(ch, ino, offset, length);
+      }
+    }
+
+    if (b != NULL) bindings_unpin(b);
+
+    // the kernel not knowing about the inode means there was nothing to invalidate
+    if (result < 0 && result != -ENOENT) SetErrorMessage(strerror(-result));
+  }
+
+ private:
+  char *mnt;
+  uint64_t ino;
+  FUSE_OFF_T offset;
+  FUSE_OFF_T length;
+  char *name;
+  char *data;
+  int result;
+};
+
+static bindings_t *bindings_notify_mount (Local<Value> mnt, bool paths) {
+  bindings_t *b = bindings_find_mounted_value(mnt);
+  if (b == NULL) {
+    Nan::ThrowError("Mount not found");
+    return NULL;
+  }
+  if (!b->lowlevel && !paths) {
+    Nan::ThrowError("Only available on lowlevel mounts, path based mounts have no inodes");
+    return NULL;
+  }
+  return b;
+}
+
+// path based mounts can only drop what the native caches hold for path, libfuse 2 has no
+// call that finds the node the kernel knows a path by, so the kernel cache runs out on its own
+static void bindings_notify_path (bindings_t *b, const char *path, FUSE_OFF_T offset) {
+  atomic_add(&(b->attr_gen), 1);
+  if (b->attr_cache != NULL) bindings_attr_cache_del(b->attr_cache, path, false);
+  if (b->negative_cache != NULL) bindings_attr_cache_del(b->negative_cache, path, false);
+  if (b->xattr_cache != NULL) bindings_xattr_cache_del(b->xattr_cache, path, false);
+  if (b->read_cache != NULL && offset >= 0) bindings_rc_del_file(b, path, 0);
+}
+
+// invalidate(mnt, ino, offset, length, cb), a negative offset only invalidates the attributes.
+// ino is a path on mounts without lowlevel, those return true and never call cb
+NAN_METHOD(Invalidate) {
+  bindings_t *b = bindings_notify_mount(info[0], true);
+  if (b == NULL) return;
+
+  FUSE_OFF_T offset = (FUSE_OFF_T) info[2]->NumberValue();
+  FUSE_OFF_T length = (FUSE_OFF_T) info[3]->NumberValue();
+
+  if (!b->lowlevel) {
+    Nan::Utf8String path(info[1]);
+    bindings_notify_path(b, *path, offset);
+    info.GetReturnValue().Set(true);
+    return;
+  }
+
+  uint64_t ino = (uint64_t) info[1]->NumberValue();
+
+  // the native caches sit in front of the kernel, so they go first
+  atomic_add(&(b->attr_gen), 1);
+  if (b->attr_cache != NULL) cache_del(b->attr_cache, &ino, sizeof(ino));
+  if (b->read_cache != NULL && offset >= 0) cache_del_prefix(b->read_cache, &ino, sizeof(ino));
+
+  Nan::Utf8String mnt(info[0]);
+  Nan::AsyncQueueWorker(new NotifyWorker(new Nan::Callback(info[4].As<Function>()), *mnt, ino, offset, length, NULL));
+}
+
+// invalidateEntry(mnt, parent, name, cb), parent is a directory path on mounts without lowlevel
+// and returns true like invalidate
+NAN_METHOD(InvalidateEntry) {
+  bindings_t *b = bindings_notify_mount(info[0], true);
+  if (b == NULL) return;
+
+  Nan::Utf8String mnt(info[0]);
+  Nan::Utf8String name(info[2]);
+
+  if (!b->lowlevel) {
+    Nan::Utf8String parent(info[1]);
+    size_t len = parent.length();
+    if (len > 0 && (*parent)[len - 1] == '/') len--;
+
+    char *path = (char *) malloc(len + name.length() + 2);
+    memcpy(path, *parent, len);
+    path[len] = '/';
+    memcpy(path + len + 1, *name, name.length() + 1);
+
+    bindings_notify_path(b, path, 0);
+    free(path);
+    info.GetReturnValue().Set(true);
+    return;
+  }
+
+  uint64_t parent = (uint64_t) info[1]->NumberValue();
+  Nan::AsyncQueueWorker(new NotifyWorker(new Nan::Callback(info[3].As<Function>()), *mnt, parent, 0, 0, *name));
+}
+
+// storeCache(mnt, ino, offset, buffer, cb)
+NAN_METHOD(StoreCache) {
+  bindings_t *b = bindings_notify_mount(info[0], false);
+  if (b == NULL) return;
+  if (!node::Buffer::HasInstance(info[3])) return Nan::ThrowError("buffer must be a Buffer");
+
+  uint64_t ino = (uint64_t) info[1]->NumberValue();
+  FUSE_OFF_T offset = (FUSE_OFF_T) info[2]->NumberValue();
+  Local<Object> buf = info[3].As<Object>();
+
+  // cached blocks of the same range would be older than what the kernel now has
+  if (b->read_cache != NULL) cache_del_prefix(b->read_cache, &ino, sizeof(ino));
+
+  // the data is copied as the buffer could change before the worker runs
+  Nan::Utf8String mnt(info[0]);
+  NotifyWorker *worker = new NotifyWorker(new Nan::Callback(info[4].As<Function>()), *mnt, ino, offset, node::Buffer::Length(buf), NULL);
+  worker->SetData(node::Buffer::Data(buf));
+  Nan::AsyncQueueWorker(worker);
+}
+#endif
+
 NAN_METHOD(SetCallback) {
+  if (callback_constructor != NULL) delete callback_constructor;
   callback_constructor = new Nan::Callback(info[0].As<Function>());
 }
 
 NAN_METHOD(SetBuffer) {
-  buffer_constructor.Reset(info[0].As<Function>());
+  if (buffer_constructor == NULL) buffer_constructor = new Nan::Persistent<Function>();
+  buffer_constructor->Reset(info[0].As<Function>());
 }
 
 NAN_METHOD(PopulateContext) {
@@ -1320,18 +4874,286 @@ NAN_METHOD(Unmount) {
   Nan::Utf8String path(info[0]);
   Local<Function> callback = info[1].As<Function>();
 
-  char *path_alloc = (char *) malloc(1024);
-  strcpy(path_alloc, *path);
+  Nan::AsyncQueueWorker(new UnmountWorker(new Nan::Callback(callback), strdup(*path)));
+}
+
+// unmountMany(mnts, cb), calls back with the result of every unmount in order
+NAN_METHOD(UnmountMany) {
+  if (!info[0]->IsArray()) return Nan::ThrowError("mnts must be an array");
+  Local<Array> mnts = info[0].As<Array>();
+  Local<Function> callback = info[1].As<Function>();
+
+  uint32_t length = mnts->Length();
+  char **paths = (char **) malloc(length * sizeof(char *));
+  for (uint32_t i = 0; i < length; i++) paths[i] = strdup(*Nan::Utf8String(mnts->Get(i)));
+
+  Nan::AsyncQueueWorker(new UnmountManyWorker(new Nan::Callback(callback), paths, length));
+}
+
+// every path mounted by this process that is not being unmounted
+NAN_METHOD(Mounted) {
+  Local<Array> mnts = Nan::New<Array>();
+  uint32_t length = 0;
+
+  mutex_lock(&mutex);
+  for (uint32_t i = 0; i < bindings_registry_size; i++) {
+    for (bindings_t *b = bindings_registry[i]; b != NULL; b = b->registry_next) {
+      if (!b->gc) mnts->Set(length++, LOCAL_STRING(b->mnt));
+    }
+  }
+  mutex_unlock(&mutex);
+
+  info.GetReturnValue().Set(mnts);
+}
+
+// attr cache methods are called with (mnt, key) where key is a path or an inode number
+static bindings_t *bindings_attr_cache_mount (Local<Value> val) {
+  bindings_t *b = bindings_find_mounted_value(val);
+  return (b == NULL || b->attr_cache == NULL) ? NULL : b;
+}
+
+NAN_METHOD(AttrCachePut) {
+  bindings_t *b = bindings_attr_cache_mount(info[0]);
+  if (b == NULL || !info[2]->IsObject()) return;
+
+  double secs = info[3]->IsNumber() ? info[3]->NumberValue() : b->attr_cache_ttl;
+  if (secs <= 0) return;
 
-  Nan::AsyncQueueWorker(new UnmountWorker(new Nan::Callback(callback), path_alloc));
+  struct FUSE_STAT stat;
+  memset(&stat, 0, sizeof(stat));
+  bindings_set_stat(&stat, info[2].As<Object>());
+
+  uint64_t expires = uv_hrtime() + (uint64_t) (secs * 1e9);
+  if (info[1]->IsNumber()) {
+    uint64_t ino = (uint64_t) info[1]->NumberValue();
+    cache_put(b->attr_cache, &ino, sizeof(ino), &stat, sizeof(stat), expires);
+  } else {
+    Nan::Utf8String key(info[1]);
+    cache_put(b->attr_cache, *key, key.length(), &stat, sizeof(stat), expires);
+  }
+}
+
+NAN_METHOD(AttrCacheInvalidate) {
+  bindings_t *b = bindings_attr_cache_mount(info[0]);
+  if (b == NULL) return;
+
+  if (info[1]->IsNumber()) {
+    uint64_t ino = (uint64_t) info[1]->NumberValue();
+    cache_del(b->attr_cache, &ino, sizeof(ino));
+  } else {
+    Nan::Utf8String key(info[1]);
+    cache_del(b->attr_cache, *key, key.length());
+  }
+}
+
+NAN_METHOD(AttrCacheInvalidatePrefix) {
+  bindings_t *b = bindings_attr_cache_mount(info[0]);
+  if (b == NULL) return;
+
+  Nan::Utf8String prefix(info[1]);
+  info.GetReturnValue().Set((uint32_t) cache_del_prefix(b->attr_cache, *prefix, prefix.length()));
+}
+
+// negativeRule(mnt, rule, add), returns whether the rule was added or removed
+NAN_METHOD(NegativeRule) {
+  bindings_t *b = bindings_find_mounted_value(info[0]);
+  if (b == NULL) return Nan::ThrowError("Mount not found");
+
+  info.GetReturnValue().Set(bindings_negative_rule(b, info[1], info[2]->BooleanValue()));
+}
+
+// negativeCacheInvalidate(mnt, [path]), forgets a learned miss or all of them
+NAN_METHOD(NegativeCacheInvalidate) {
+  bindings_t *b = bindings_find_mounted_value(info[0]);
+  if (b == NULL || b->negative_cache == NULL) return;
+
+  if (!info[1]->IsString()) {
+    cache_clear(b->negative_cache);
+    return;
+  }
+
+  Nan::Utf8String path(info[1]);
+  cache_del(b->negative_cache, *path, path.length());
+}
+
+// xattrCacheInvalidate(mnt, [path]), drops everything cached for path or the whole cache
+NAN_METHOD(XattrCacheInvalidate) {
+  bindings_t *b = bindings_find_mounted_value(info[0]);
+  if (b == NULL || b->xattr_cache == NULL) return;
+
+  if (!info[1]->IsString()) {
+    cache_clear(b->xattr_cache);
+    return;
+  }
+
+  Nan::Utf8String path(info[1]);
+  bindings_xattr_cache_del(b->xattr_cache, *path, false);
+}
+
+static Local<Object> bindings_cache_stats (cache_t *cache) {
+  Local<Object> stats = Nan::New<Object>();
+
+  mutex_lock(&(cache->lock));
+  stats->Set(LOCAL_STRING("entries"), Nan::New<Number>(cache->length));
+  stats->Set(LOCAL_STRING("size"), Nan::New<Number>(cache->size));
+  stats->Set(LOCAL_STRING("maxSize"), Nan::New<Number>(cache->max_size));
+  stats->Set(LOCAL_STRING("hits"), Nan::New<Number>(cache->hits));
+  stats->Set(LOCAL_STRING("misses"), Nan::New<Number>(cache->misses));
+  stats->Set(LOCAL_STRING("evictions"), Nan::New<Number>(cache->evictions));
+  mutex_unlock(&(cache->lock));
+
+  return stats;
+}
+
+static void bindings_cache_reset_stats (cache_t *cache) {
+  mutex_lock(&(cache->lock));
+  cache->hits = cache->misses = cache->evictions = 0;
+  mutex_unlock(&(cache->lock));
+}
+
+NAN_METHOD(AttrCacheStats) {
+  bindings_t *b = bindings_attr_cache_mount(info[0]);
+  if (b == NULL) return;
+  info.GetReturnValue().Set(bindings_cache_stats(b->attr_cache));
+}
+
+// summary of a histogram in microseconds
+static Local<Object> bindings_hist_summary (bindings_hist_t *h) {
+  static const double percentiles[] = {0.5, 0.9, 0.99, 0.999};
+  static const char *names[] = {"p50", "p90", "p99", "p999"};
+
+  uint64_t buckets[BINDINGS_HIST_BUCKETS];
+  uint64_t count = 0;
+  int max = 0;
+
+  for (int i = 0; i < BINDINGS_HIST_BUCKETS; i++) {
+    buckets[i] = h->buckets[i];
+    count += buckets[i];
+    if (buckets[i]) max = i;
+  }
+
+  Local<Object> summary = Nan::New<Object>();
+  summary->Set(LOCAL_STRING("count"), Nan::New<Number>(count));
+  summary->Set(LOCAL_STRING("mean"), Nan::New<Number>(count ? h->sum / 1e3 / count : 0));
+
+  int p = 0;
+  uint64_t seen = 0;
+  for (int i = 0; i < BINDINGS_HIST_BUCKETS && p < 4; i++) {
+    seen += buckets[i];
+    while (p < 4 && count && seen >= percentiles[p] * count) {
+      summary->Set(LOCAL_STRING(names[p++]), Nan::New<Number>(bindings_hist_value(i) / 1e3));
+    }
+  }
+  for (; p < 4; p++) summary->Set(LOCAL_STRING(names[p]), Nan::New<Number>(0));
+
+  summary->Set(LOCAL_STRING("max"), Nan::New<Number>(count ? bindings_hist_value(max) / 1e3 : 0));
+  return summary;
+}
+
+NAN_METHOD(Stats) {
+  bindings_t *b = bindings_find_mounted_value(info[0]);
+  if (b == NULL) return;
+
+  Local<Object> stats = Nan::New<Object>();
+  Local<Object> ops = Nan::New<Object>();
+
+  stats->Set(LOCAL_STRING("inflight"), Nan::New<Number>(atomic_get(&(b->inflight))));
+  stats->Set(LOCAL_STRING("queued"), Nan::New<Number>(atomic_get(&(b->queued))));
+
+  for (int i = 0; i < BINDINGS_OPS_LENGTH; i++) {
+    bindings_op_stats_t *op = b->stats[i];
+    if (op == NULL) continue;
+
+    uint32_t inflight = atomic_get(&(op->inflight));
+    if (!op->total.count && !op->queue.count && !inflight) continue;
+
+    Local<Object> entry = Nan::New<Object>();
+    entry->Set(LOCAL_STRING("inflight"), Nan::New<Number>(inflight));
+    entry->Set(LOCAL_STRING("queue"), bindings_hist_summary(&(op->queue)));
+    entry->Set(LOCAL_STRING("handler"), bindings_hist_summary(&(op->handler)));
+    entry->Set(LOCAL_STRING("total"), bindings_hist_summary(&(op->total)));
+    ops->Set(LOCAL_STRING(bindings_ops_names[i]), entry);
+  }
+
+  stats->Set(LOCAL_STRING("ops"), ops);
+  if (b->path_cache != NULL) stats->Set(LOCAL_STRING("pathCache"), bindings_cache_stats(b->path_cache));
+  if (b->xattr_cache != NULL) stats->Set(LOCAL_STRING("xattrCache"), bindings_cache_stats(b->xattr_cache));
+  if (b->negative_cache != NULL) stats->Set(LOCAL_STRING("negativeCache"), bindings_cache_stats(b->negative_cache));
+  stats->Set(LOCAL_STRING("negativeRules"), Nan::New<Number>((double) b->negative_rules->hits));
+  if (b->read_cache != NULL) {
+    Local<Object> read_cache = bindings_cache_stats(b->read_cache);
+    read_cache->Set(LOCAL_STRING("prefetches"), Nan::New<Number>((double) b->prefetches));
+    stats->Set(LOCAL_STRING("readCache"), read_cache);
+  }
+  if (b->deferred_max > 0) {
+    Local<Object> deferred = Nan::New<Object>();
+    deferred->Set(LOCAL_STRING("pending"), Nan::New<Number>(atomic_get(&(b->deferred))));
+    deferred->Set(LOCAL_STRING("maxQueue"), Nan::New<Number>(b->deferred_max));
+    deferred->Set(LOCAL_STRING("deferred"), Nan::New<Number>((double) b->deferred_total));
+    deferred->Set(LOCAL_STRING("overflows"), Nan::New<Number>((double) b->deferred_overflows));
+    stats->Set(LOCAL_STRING("asyncRelease"), deferred);
+  }
+  info.GetReturnValue().Set(stats);
+}
+
+NAN_METHOD(ResetStats) {
+  bindings_t *b = bindings_find_mounted_value(info[0]);
+  if (b == NULL) return;
+
+  // the gauges track live requests so only the histograms are cleared
+  for (int i = 0; i < BINDINGS_OPS_LENGTH; i++) {
+    bindings_op_stats_t *op = b->stats[i];
+    if (op == NULL) continue;
+    bindings_hist_reset(&(op->queue));
+    bindings_hist_reset(&(op->handler));
+    bindings_hist_reset(&(op->total));
+  }
+
+  if (b->path_cache != NULL) bindings_cache_reset_stats(b->path_cache);
+  if (b->xattr_cache != NULL) bindings_cache_reset_stats(b->xattr_cache);
+  if (b->negative_cache != NULL) bindings_cache_reset_stats(b->negative_cache);
+  b->negative_rules->hits = 0;
+  if (b->read_cache != NULL) {
+    bindings_cache_reset_stats(b->read_cache);
+    bindings_counter_reset(&(b->prefetches));
+  }
+  bindings_counter_reset(&(b->deferred_total));
+  bindings_counter_reset(&(b->deferred_overflows));
 }
 
 void Init(Handle<Object> exports) {
+  bindings_init_keys();
+
   exports->Set(LOCAL_STRING("setCallback"), Nan::New<FunctionTemplate>(SetCallback)->GetFunction());
   exports->Set(LOCAL_STRING("setBuffer"), Nan::New<FunctionTemplate>(SetBuffer)->GetFunction());
   exports->Set(LOCAL_STRING("mount"), Nan::New<FunctionTemplate>(Mount)->GetFunction());
   exports->Set(LOCAL_STRING("unmount"), Nan::New<FunctionTemplate>(Unmount)->GetFunction());
+  exports->Set(LOCAL_STRING("unmountMany"), Nan::New<FunctionTemplate>(UnmountMany)->GetFunction());
+  exports->Set(LOCAL_STRING("mounted"), Nan::New<FunctionTemplate>(Mounted)->GetFunction());
+  exports->Set(LOCAL_STRING("STAT_LENGTH"), Nan::New<Number>(STAT_LENGTH));
+  exports->Set(LOCAL_STRING("STAT_ATIME_SEC"), Nan::New<Number>(STAT_ATIME_SEC));
+  exports->Set(LOCAL_STRING("attach"), Nan::New<FunctionTemplate>(Attach)->GetFunction());
+  exports->Set(LOCAL_STRING("detach"), Nan::New<FunctionTemplate>(Detach)->GetFunction());
+#ifndef _WIN32
+  exports->Set(LOCAL_STRING("invalidate"), Nan::New<FunctionTemplate>(Invalidate)->GetFunction());
+  exports->Set(LOCAL_STRING("invalidateEntry"), Nan::New<FunctionTemplate>(InvalidateEntry)->GetFunction());
+  exports->Set(LOCAL_STRING("storeCache"), Nan::New<FunctionTemplate>(StoreCache)->GetFunction());
+#endif
   exports->Set(LOCAL_STRING("populateContext"), Nan::New<FunctionTemplate>(PopulateContext)->GetFunction());
+  exports->Set(LOCAL_STRING("attrCachePut"), Nan::New<FunctionTemplate>(AttrCachePut)->GetFunction());
+  exports->Set(LOCAL_STRING("attrCacheInvalidate"), Nan::New<FunctionTemplate>(AttrCacheInvalidate)->GetFunction());
+  exports->Set(LOCAL_STRING("attrCacheInvalidatePrefix"), Nan::New<FunctionTemplate>(AttrCacheInvalidatePrefix)->GetFunction());
+  exports->Set(LOCAL_STRING("xattrCacheInvalidate"), Nan::New<FunctionTemplate>(XattrCacheInvalidate)->GetFunction());
+  exports->Set(LOCAL_STRING("negativeRule"), Nan::New<FunctionTemplate>(NegativeRule)->GetFunction());
+  exports->Set(LOCAL_STRING("negativeCacheInvalidate"), Nan::New<FunctionTemplate>(NegativeCacheInvalidate)->GetFunction());
+  exports->Set(LOCAL_STRING("attrCacheStats"), Nan::New<FunctionTemplate>(AttrCacheStats)->GetFunction());
+  exports->Set(LOCAL_STRING("stats"), Nan::New<FunctionTemplate>(Stats)->GetFunction());
+  exports->Set(LOCAL_STRING("resetStats"), Nan::New<FunctionTemplate>(ResetStats)->GetFunction());
 }
 
+// loadable from worker_threads
+#ifdef NAN_MODULE_WORKER_ENABLED
+NAN_MODULE_WORKER_ENABLED(fuse_bindings, Init)
+#else
 NODE_MODULE(fuse_bindings, Init)
+#endif
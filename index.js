@@ -7,6 +7,32 @@ var path = require('path')
 var noop = function () {}
 var call = function (cb) { cb() }
 
+var packTime = function (arr, i, date) {
+  var ms = date ? date.getTime() : 0
+  var secs = Math.floor(ms / 1000)
+  arr[i] = secs
+  arr[i + 1] = Math.round((ms - secs * 1000) * 1000000)
+}
+
+var defaultGetattr = function (lowlevel) {
+  var root = lowlevel ? 1 : '/'
+  return function (path, cb) {
+    if (path !== root) return cb(fuse.EPERM)
+    cb(null, {mtime: new Date(0), atime: new Date(0), ctime: new Date(0), mode: 16877, size: 4096})
+  }
+}
+
+// the native kernel cache calls throw for unknown mounts and storeCache on mounts that are not lowlevel
+var notify = function (cb, fn) {
+  if (!cb) cb = noop
+  if (!fuse.invalidate) return process.nextTick(cb, new Error('Not supported on this platform'))
+  try {
+    fn(cb)
+  } catch (err) {
+    process.nextTick(cb, err)
+  }
+}
+
 var IS_OSX = os.platform() === 'darwin'
 var OSX_FOLDER_ICON = '/System/Library/CoreServices/CoreTypes.bundle/Contents/Resources/GenericFolderIcon.icns'
 var HAS_FOLDER_ICON = IS_OSX && fs.existsSync(OSX_FOLDER_ICON)
@@ -37,6 +63,10 @@ exports.mount = function (mnt, ops, opts, cb) {
   if (/\*|(^,)fuse-bindings(,$)/.test(process.env.DEBUG)) ops.options = ['debug'].concat(ops.options || [])
   mnt = path.resolve(mnt)
 
+  if (ops.lowlevel && ops.xattrCache) {
+    return setImmediate(cb.bind(null, new Error('ops.xattrCache is not available in lowlevel mode')))
+  }
+
   if (ops.displayFolder && IS_OSX) { // only works on osx
     if (!ops.options) ops.options = []
     ops.options.push('volname=' + path.basename(mnt))
@@ -49,9 +79,10 @@ exports.mount = function (mnt, ops, opts, cb) {
   }
 
   var init = ops.init || call
-  ops.init = function (next) {
+  ops.init = function (conn, next) {
     callback()
-    if (init.length > 1) init(mnt, next) // backwards compat for now
+    if (init.length > 2) init(mnt, conn, next) // conn is what the kernel negotiated
+    else if (init.length > 1) init(mnt, next) // backwards compat for now
     else init(next)
   }
 
@@ -61,12 +92,9 @@ exports.mount = function (mnt, ops, opts, cb) {
     error(next)
   }
 
-  if (!ops.getattr) { // we need this for unmount to work on osx
-    ops.getattr = function (path, cb) {
-      if (path !== '/') return cb(fuse.EPERM)
-      cb(null, {mtime: new Date(0), atime: new Date(0), ctime: new Date(0), mode: 16877, size: 4096})
-    }
-  }
+  if (ops.readdir && !ops.lowlevel && ops.readdir.length > 2) ops.readdirOffset = true // readdir(path, offset, cb)
+
+  if (!ops.getattr) ops.getattr = defaultGetattr(ops.lowlevel) // we need this for unmount to work on osx
 
   var mount = function () {
     // TODO: I got a feeling this can be done better
@@ -76,22 +104,224 @@ exports.mount = function (mnt, ops, opts, cb) {
         if (!stat.isDirectory()) return cb(new Error('Mountpoint is not a directory'))
         fs.stat(path.join(mnt, '..'), function (_, parent) {
           if (parent && parent.dev !== stat.dev) return cb(new Error('Mountpoint in use'))
-          fuse.mount(mnt, ops)
+          start()
         })
       })
     } else {
-      fuse.mount(mnt, ops)
+      start()
     }
   }
 
+  var start = function () {
+    if (!ops.workers) return fuse.mount(mnt, ops)
+    spawn(mnt, ops, callback)
+  }
+
   if (!ops.force) return mount()
   exports.unmount(mnt, mount)
 }
 
+// runs the handlers of ops.workers.module in worker_threads, only init, error and destroy stay on this thread.
+// cb is only called with an error, when a worker fails before or after the mount is up
+var spawn = function (mnt, ops, cb) {
+  var Worker = require('worker_threads').Worker
+  var count = Math.min(ops.workers.count || os.cpus().length, 255)
+  var routing = ops.workers.routing || 'round-robin'
+  var workerData = {mnt: mnt, module: path.resolve(ops.workers.module), lowlevel: !!ops.lowlevel}
+  var workers = []
+  var missing = count
+  var mounted = false
+  var initialized = false
+  var aborted = false
+  var failed = null
+
+  // the mount can only be unmounted once it is up, see the init hook below
+  var init = ops.init
+  ops.init = function (conn, next) {
+    initialized = true
+    init(conn, next)
+    if (failed) setImmediate(unmount)
+  }
+
+  for (var i = 0; i < count; i++) {
+    var worker = new Worker(path.join(__dirname, 'worker.js'), {workerData: xtend(workerData, {index: i})})
+    worker.once('message', onready)
+    worker.on('error', onerror)
+    worker.once('exit', onexit.bind(null, i))
+    workers.push(worker)
+  }
+
+  function onready (msg) {
+    if (failed || --missing) return
+
+    // the mount only needs to know which ops exist, the workers answer them
+    msg.ops.forEach(function (name) {
+      if (!ops[name]) ops[name] = noop
+    })
+    if (msg.readdirOffset) ops.readdirOffset = true
+    ops.workers = count
+    ops.workerRouting = routing
+
+    mounted = true
+    fuse.mount(mnt, ops)
+    workers.forEach(function (worker) {
+      worker.postMessage('attach')
+    })
+  }
+
+  // the worker exits right after, onexit cleans up
+  function onerror (err) {
+    if (!failed) failed = err
+  }
+
+  function onexit (index) {
+    if (!mounted) {
+      if (aborted) return
+      aborted = true
+      if (!failed) failed = new Error('Worker exited')
+      workers.forEach(function (worker) {
+        worker.terminate()
+      })
+      return cb(failed)
+    }
+
+    // false once the mount is going away anyway, then this is just the worker shutting down
+    if (!fuse.detach(mnt, index)) return
+    if (!failed) failed = new Error('Worker exited')
+    cb(failed)
+    if (initialized) unmount()
+  }
+
+  function unmount () {
+    fuse.unmount(mnt, function () {
+      workers.forEach(function (worker) {
+        worker.terminate()
+      })
+    })
+  }
+}
+
+// used by worker.js to serve a mount from a worker thread
+exports.attach = function (mnt, index, ops, lowlevel) {
+  ops = xtend(ops)
+  if (!ops.getattr) ops.getattr = defaultGetattr(lowlevel)
+  fuse.attach(mnt, index, ops)
+}
+
 exports.unmount = function (mnt, cb) {
   fuse.unmount(path.resolve(mnt), cb)
 }
 
+exports.unmountMany = function (mnts, cb) {
+  if (!cb) cb = noop
+  mnts = mnts.map(function (mnt) {
+    return path.resolve(mnt)
+  })
+
+  fuse.unmountMany(mnts, function (_, codes) {
+    var error = null
+    var results = mnts.map(function (mnt, i) {
+      var err = codes[i] ? new Error('Failed to unmount ' + mnt) : null
+      if (err && !error) error = err
+      return {mnt: mnt, error: err}
+    })
+    cb(error, results)
+  })
+}
+
+exports.unmountAll = function (cb) {
+  exports.unmountMany(fuse.mounted(), cb)
+}
+
+exports.mounted = function () {
+  return fuse.mounted()
+}
+
+exports.putAttr = function (mnt, key, stat, ttl) {
+  fuse.attrCachePut(path.resolve(mnt), key, stat, ttl)
+}
+
+exports.invalidateAttr = function (mnt, key) {
+  fuse.attrCacheInvalidate(path.resolve(mnt), key)
+}
+
+exports.invalidateAttrPrefix = function (mnt, prefix) {
+  return fuse.attrCacheInvalidatePrefix(path.resolve(mnt), prefix) || 0
+}
+
+exports.invalidateXattr = function (mnt, file) {
+  fuse.xattrCacheInvalidate(path.resolve(mnt), file)
+}
+
+exports.addNegativeRule = function (mnt, rule) {
+  fuse.negativeRule(path.resolve(mnt), rule, true)
+}
+
+exports.removeNegativeRule = function (mnt, rule) {
+  return fuse.negativeRule(path.resolve(mnt), rule, false)
+}
+
+exports.invalidateNegative = function (mnt, file) {
+  fuse.negativeCacheInvalidate(path.resolve(mnt), file)
+}
+
+exports.attrCacheStats = function (mnt) {
+  return fuse.attrCacheStats(path.resolve(mnt)) || null
+}
+
+// the kernel cache calls take inodes on lowlevel mounts and paths otherwise, path based
+// mounts only drop the native caches and return true instead of calling back
+exports.invalidate = function (mnt, ino, opts, cb) {
+  if (typeof opts === 'function') return exports.invalidate(mnt, ino, null, opts)
+  if (!opts) opts = {}
+  notify(cb, function (done) {
+    if (fuse.invalidate(path.resolve(mnt), ino, opts.offset || 0, opts.length || 0, done)) process.nextTick(done)
+  })
+}
+
+exports.invalidateEntry = function (mnt, parent, name, cb) {
+  notify(cb, function (done) {
+    if (fuse.invalidateEntry(path.resolve(mnt), parent, name, done)) process.nextTick(done)
+  })
+}
+
+// the page cache can only be reached through an inode, which path based mounts never see
+exports.storeCache = function (mnt, ino, offset, buf, cb) {
+  if (typeof ino !== 'number') return process.nextTick(cb || noop, new Error('storeCache takes an inode and is only available in lowlevel mode'))
+  notify(cb, function (done) {
+    fuse.storeCache(path.resolve(mnt), ino, offset, buf, done)
+  })
+}
+
+exports.stats = function (mnt) {
+  return fuse.stats(path.resolve(mnt)) || null
+}
+
+exports.resetStats = function (mnt) {
+  fuse.resetStats(path.resolve(mnt))
+}
+
+// slots of packed stat replies, times are split into seconds and nanoseconds
+exports.STAT_FIELDS = ['dev', 'ino', 'mode', 'nlink', 'uid', 'gid', 'rdev', 'size', 'blocks', 'blksize', 'atimeSec', 'atimeNsec', 'mtimeSec', 'mtimeNsec', 'ctimeSec', 'ctimeNsec']
+exports.STATFS_FIELDS = ['bsize', 'frsize', 'blocks', 'bfree', 'bavail', 'files', 'ffree', 'favail', 'fsid', 'flag', 'namemax']
+
+// the layout comes from the native layer, plain fields up to STAT_ATIME_SEC then two slots per time
+exports.packStat = function (st, arr) {
+  var times = fuse.STAT_ATIME_SEC
+  if (!arr) arr = new Float64Array(fuse.STAT_LENGTH)
+  for (var i = 0; i < times; i++) arr[i] = st[exports.STAT_FIELDS[i]] || 0
+  packTime(arr, times, st.atime)
+  packTime(arr, times + 2, st.mtime)
+  packTime(arr, times + 4, st.ctime)
+  return arr
+}
+
+exports.packStatfs = function (st, arr) {
+  if (!arr) arr = new Float64Array(exports.STATFS_FIELDS.length)
+  for (var i = 0; i < exports.STATFS_FIELDS.length; i++) arr[i] = st[exports.STATFS_FIELDS[i]] || 0
+  return arr
+}
+
 exports.errno = function (code) {
   return (code && exports[code.toUpperCase()]) || -1
 }
@@ -0,0 +1,192 @@
+#include "matcher.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct matcher_glob_t {
+  matcher_glob_t *next;
+  char *rule;
+  const char *rest; // rule after its literal head
+};
+
+struct matcher_node_t {
+  matcher_node_t *children;
+  matcher_node_t *next; // sibling
+  char c;
+  uint32_t prefixes; // prefix rules ending here
+  matcher_glob_t *globs;
+};
+
+static matcher_node_t *matcher_node_alloc (char c) {
+  matcher_node_t *node = (matcher_node_t *) calloc(1, sizeof(matcher_node_t));
+  node->c = c;
+  return node;
+}
+
+static void matcher_node_free (matcher_node_t *node) {
+  while (node->children != NULL) {
+    matcher_node_t *child = node->children;
+    node->children = child->next;
+    matcher_node_free(child);
+  }
+  while (node->globs != NULL) {
+    matcher_glob_t *g = node->globs;
+    node->globs = g->next;
+    free(g->rule);
+    free(g);
+  }
+  free(node);
+}
+
+static matcher_node_t *matcher_child (matcher_node_t *node, char c, int create) {
+  for (matcher_node_t *child = node->children; child != NULL; child = child->next) {
+    if (child->c == c) return child;
+  }
+  if (!create) return NULL;
+
+  matcher_node_t *child = matcher_node_alloc(c);
+  child->next = node->children;
+  node->children = child;
+  return child;
+}
+
+// follows the first length characters of a rule, its literal head for a glob
+static matcher_node_t *matcher_walk_rule (matcher_node_t *node, const char *rule, size_t length, int create) {
+  for (size_t i = 0; i < length && node != NULL; i++) node = matcher_child(node, rule[i], create);
+  return node;
+}
+
+static size_t matcher_literal_length (const char *glob) {
+  return strcspn(glob, "*?");
+}
+
+static int matcher_glob (const char *p, const char *s) {
+  while (*p) {
+    if (p[0] == '*' && p[1] == '*') {
+      p += 2;
+      // a/**/b also matches a/b
+      if (*p == '/' && matcher_glob(p + 1, s)) return 1;
+      for (;; s++) {
+        if (matcher_glob(p, s)) return 1;
+        if (!*s) return 0;
+      }
+    }
+
+    if (*p == '*') {
+      p++;
+      for (;; s++) {
+        if (matcher_glob(p, s)) return 1;
+        if (!*s || *s == '/') return 0;
+      }
+    }
+
+    if (!*s || (*p == '?' ? *s == '/' : *p != *s)) return 0;
+    p++;
+    s++;
+  }
+
+  return !*s;
+}
+
+// a prefix only matches whole components, /tmp matches /tmp and /tmp/a but not /tmpfoo
+static int matcher_walk (matcher_node_t *node, const char *s) {
+  while (node != NULL) {
+    if (node->prefixes > 0 && (!*s || *s == '/' || node->c == '/' || node->c == 0)) return 1;
+    for (matcher_glob_t *g = node->globs; g != NULL; g = g->next) {
+      if (matcher_glob(g->rest, s)) return 1;
+    }
+    if (!*s) return 0;
+    node = matcher_child(node, *(s++), 0);
+  }
+  return 0;
+}
+
+static matcher_node_t *matcher_root (matcher_t *matcher, const char *rule, int prefix) {
+  return prefix || strchr(rule, '/') != NULL ? matcher->paths : matcher->names;
+}
+
+void matcher_init (matcher_t *matcher) {
+  memset(matcher, 0, sizeof(matcher_t));
+  mutex_init(&(matcher->lock));
+  matcher->paths = matcher_node_alloc(0);
+  matcher->names = matcher_node_alloc(0);
+}
+
+void matcher_destroy (matcher_t *matcher) {
+  matcher_node_free(matcher->paths);
+  matcher_node_free(matcher->names);
+  mutex_destroy(&(matcher->lock));
+}
+
+void matcher_add (matcher_t *matcher, const char *rule, int prefix) {
+  size_t length = prefix ? strlen(rule) : matcher_literal_length(rule);
+
+  mutex_lock(&(matcher->lock));
+  matcher_node_t *node = matcher_walk_rule(matcher_root(matcher, rule, prefix), rule, length, 1);
+
+  if (prefix) {
+    node->prefixes++;
+  } else {
+    matcher_glob_t *g = (matcher_glob_t *) malloc(sizeof(matcher_glob_t));
+    g->rule = strdup(rule);
+    g->rest = g->rule + length;
+    g->next = node->globs;
+    node->globs = g;
+  }
+
+  matcher->length++;
+  mutex_unlock(&(matcher->lock));
+}
+
+int matcher_remove (matcher_t *matcher, const char *rule, int prefix) {
+  size_t length = prefix ? strlen(rule) : matcher_literal_length(rule);
+  int removed = 0;
+
+  mutex_lock(&(matcher->lock));
+  matcher_node_t *node = matcher_walk_rule(matcher_root(matcher, rule, prefix), rule, length, 0);
+
+  if (node != NULL && prefix && node->prefixes > 0) {
+    node->prefixes--;
+    removed = 1;
+  } else if (node != NULL && !prefix) {
+    for (matcher_glob_t **g = &(node->globs); *g != NULL; g = &((*g)->next)) {
+      if (strcmp((*g)->rule, rule)) continue;
+      matcher_glob_t *found = *g;
+      *g = found->next;
+      free(found->rule);
+      free(found);
+      removed = 1;
+      break;
+    }
+  }
+
+  if (removed) matcher->length--;
+  mutex_unlock(&(matcher->lock));
+
+  return removed;
+}
+
+int matcher_match (matcher_t *matcher, const char *path) {
+  if (atomic_get(&(matcher->length)) == 0) return 0;
+
+  const char *name = strrchr(path, '/');
+  name = name != NULL ? name + 1 : path;
+
+  mutex_lock(&(matcher->lock));
+  int match = matcher_walk(matcher->paths, path) || (*name && matcher_walk(matcher->names, name));
+  if (match) matcher->hits++;
+  mutex_unlock(&(matcher->lock));
+
+  return match;
+}
+
+int matcher_match_name (matcher_t *matcher, const char *name) {
+  if (atomic_get(&(matcher->length)) == 0) return 0;
+
+  mutex_lock(&(matcher->lock));
+  int match = matcher_walk(matcher->names, name);
+  if (match) matcher->hits++;
+  mutex_unlock(&(matcher->lock));
+
+  return match;
+}
@@ -0,0 +1,33 @@
+#ifndef FUSE_BINDINGS_MATCHER_H
+#define FUSE_BINDINGS_MATCHER_H
+
+#include "abstractions.h"
+
+// Set of prefix and glob rules over paths. Rules are kept in a trie keyed by their literal head,
+// so a lookup walks the path once and only tries the globs hanging off the nodes it passes.
+// Prefixes match whole path components, the path itself and everything below it.
+// In globs * and ? do not match /, ** matches anything. Globs without a / are matched against
+// the last path component, everything else against the full path. All functions are thread safe.
+
+struct matcher_node_t;
+
+struct matcher_t {
+  abstr_mutex_t lock;
+  matcher_node_t *paths; // prefixes and globs with a /
+  matcher_node_t *names; // globs matched against the last component
+  volatile uint32_t length;
+  uint64_t hits;
+};
+
+void matcher_init (matcher_t *matcher);
+void matcher_destroy (matcher_t *matcher);
+
+// adding a rule twice needs two removes, remove returns 0 if there was no such rule
+void matcher_add (matcher_t *matcher, const char *rule, int prefix);
+int matcher_remove (matcher_t *matcher, const char *rule, int prefix);
+
+// returns 1 if any rule matches, match_name only consults the last component rules
+int matcher_match (matcher_t *matcher, const char *path);
+int matcher_match_name (matcher_t *matcher, const char *name);
+
+#endif
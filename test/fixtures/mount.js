@@ -0,0 +1,24 @@
+var fuse = require('../../')
+var mnt = require('./mnt')
+var stat = require('./stat')
+
+// mounts ops on mnt with a directory at / and calls fn(done), done unmounts and ends the test
+module.exports = function (t, ops, fn) {
+  var getattr = ops.getattr
+
+  ops.force = true
+  ops.getattr = function (path, cb) {
+    if (path === '/') return cb(0, stat({mode: 'dir', size: 4096}))
+    if (!getattr) return cb(fuse.ENOENT)
+    getattr(path, cb)
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+    fn(function () {
+      fuse.unmount(mnt, function () {
+        t.end()
+      })
+    })
+  })
+}
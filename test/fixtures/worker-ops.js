@@ -0,0 +1,24 @@
+var threadId = require('worker_threads').threadId
+var stat = require('./stat')
+var fuse = require('../../')
+
+exports.getattr = function (path, cb) {
+  if (path === '/') return cb(0, stat({mode: 'dir', size: 4096}))
+  if (path === '/thread') return cb(0, stat({mode: 'file', size: String(threadId).length}))
+  cb(fuse.ENOENT)
+}
+
+exports.readdir = function (path, cb) {
+  cb(0, ['thread'])
+}
+
+exports.open = function (path, flags, cb) {
+  cb(0, {threadId: threadId}) // kept in the file table of this worker
+}
+
+exports.read = function (path, fd, buf, len, pos, cb) {
+  var str = String(fd.threadId).slice(pos, pos + len)
+  if (!str) return cb(0)
+  buf.write(str)
+  cb(str.length)
+}
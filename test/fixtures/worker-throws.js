@@ -0,0 +1 @@
+throw new Error('broken worker module')
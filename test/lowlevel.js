@@ -0,0 +1,334 @@
+var mnt = require('./fixtures/mnt')
+var stat = require('./fixtures/stat')
+var mount = require('./fixtures/mount')
+var fuse = require('../')
+var tape = require('tape')
+var fs = require('fs')
+var path = require('path')
+
+tape('lowlevel', function (t) {
+  var root = stat({mode: 'dir', size: 4096})
+  var file = stat({mode: 'file', size: 11})
+  root.ino = 1
+  file.ino = 2
+
+  var ops = {
+    force: true,
+    lowlevel: true,
+    lookup: function (parent, name, cb) {
+      if (parent === 1 && name === 'test') return cb(0, file)
+      return cb(fuse.ENOENT)
+    },
+    getattr: function (ino, cb) {
+      if (ino === 1) return cb(0, root)
+      if (ino === 2) return cb(0, file)
+      return cb(fuse.ENOENT)
+    },
+    readdir: function (ino, offset, cb) {
+      if (ino !== 1) return cb(fuse.ENOENT)
+      cb(0, ['.', '..', 'test'].slice(offset), [root, root, file].slice(offset))
+    },
+    open: function (ino, flags, cb) {
+      cb(0, 42)
+    },
+    read: function (ino, fd, buf, len, pos, cb) {
+      t.same(ino, 2, 'read the right inode')
+      var str = 'hello world'.slice(pos, pos + len)
+      if (!str) return cb(0)
+      buf.write(str)
+      return cb(str.length)
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+
+    fs.readdir(mnt, function (err, list) {
+      t.error(err, 'no error')
+      t.same(list, ['test'], 'listed directory')
+
+      fs.readFile(path.join(mnt, 'test'), function (err, buf) {
+        t.error(err, 'no error')
+        t.same(buf, new Buffer('hello world'), 'read file')
+
+        fuse.unmount(mnt, function () {
+          t.end()
+        })
+      })
+    })
+  })
+})
+
+tape('lowlevel (invalidate)', function (t) {
+  var content = 'hello world'
+  var root = stat({mode: 'dir', size: 4096})
+  var file = stat({mode: 'file', size: 11})
+  root.ino = 1
+  file.ino = 2
+
+  var ops = {
+    force: true,
+    lowlevel: true,
+    attrTimeout: 3600,
+    entryTimeout: 3600,
+    lookup: function (parent, name, cb) {
+      if (parent === 1 && name === 'test') return cb(0, file)
+      return cb(fuse.ENOENT)
+    },
+    getattr: function (ino, cb) {
+      if (ino === 1) return cb(0, root)
+      if (ino === 2) return cb(0, file)
+      return cb(fuse.ENOENT)
+    },
+    open: function (ino, flags, cb) {
+      cb(0, 42, {keepCache: true})
+    },
+    read: function (ino, fd, buf, len, pos, cb) {
+      var str = content.slice(pos, pos + len)
+      if (!str) return cb(0)
+      buf.write(str)
+      return cb(str.length)
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+
+    fs.readFile(path.join(mnt, 'test'), 'utf-8', function (err, str) {
+      t.error(err, 'no error')
+      t.same(str, 'hello world', 'read file')
+      content = 'HELLO WORLD'
+
+      fuse.invalidate(mnt, 2, function (err) {
+        t.error(err, 'no error')
+        fs.readFile(path.join(mnt, 'test'), 'utf-8', function (err, str) {
+          t.error(err, 'no error')
+          t.same(str, 'HELLO WORLD', 'read the new content')
+
+          fuse.unmount(mnt, function () {
+            t.end()
+          })
+        })
+      })
+    })
+  })
+})
+
+tape('lowlevel (store cache)', function (t) {
+  var reads = 0
+  var root = stat({mode: 'dir', size: 4096})
+  var file = stat({mode: 'file', size: 11})
+  root.ino = 1
+  file.ino = 2
+
+  var ops = {
+    force: true,
+    lowlevel: true,
+    attrTimeout: 3600,
+    entryTimeout: 3600,
+    lookup: function (parent, name, cb) {
+      if (parent === 1 && name === 'test') return cb(0, file)
+      return cb(fuse.ENOENT)
+    },
+    getattr: function (ino, cb) {
+      if (ino === 1) return cb(0, root)
+      if (ino === 2) return cb(0, file)
+      return cb(fuse.ENOENT)
+    },
+    open: function (ino, flags, cb) {
+      cb(0, 42, {keepCache: true})
+    },
+    read: function (ino, fd, buf, len, pos, cb) {
+      reads++
+      cb(0)
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+
+    fs.stat(path.join(mnt, 'test'), function (err) {
+      t.error(err, 'no error')
+      fuse.storeCache(mnt, 2, 0, new Buffer('hello world'), function (err) {
+        t.error(err, 'no error')
+        fs.readFile(path.join(mnt, 'test'), 'utf-8', function (err, str) {
+          t.error(err, 'no error')
+          t.same(str, 'hello world', 'read from the page cache')
+          t.same(reads, 0, 'read handler was not called')
+
+          fuse.unmount(mnt, function () {
+            t.end()
+          })
+        })
+      })
+    })
+  })
+})
+
+tape('store cache needs lowlevel', function (t) {
+  mount(t, {}, function (done) {
+    fuse.storeCache(mnt, '/test', 0, new Buffer('hello world'), function (err) {
+      t.ok(err, 'refused a path')
+      fuse.storeCache(mnt, 2, 0, new Buffer('hello world'), function (err) {
+        t.ok(err, 'refused a path based mount')
+        done()
+      })
+    })
+  })
+})
+
+tape('lowlevel (create with ttl)', function (t) {
+  var getattrs = 0
+  var root = stat({mode: 'dir', size: 4096})
+  var file = stat({mode: 'file', size: 0})
+  root.ino = 1
+  file.ino = 2
+
+  var ops = {
+    force: true,
+    lowlevel: true,
+    attrTimeout: 0,
+    entryTimeout: 0,
+    lookup: function (parent, name, cb) {
+      cb(fuse.ENOENT)
+    },
+    getattr: function (ino, cb) {
+      if (ino === 1) return cb(0, root)
+      getattrs++
+      if (ino === 2) return cb(0, file)
+      return cb(fuse.ENOENT)
+    },
+    create: function (parent, name, mode, cb) {
+      cb(0, file, 42, null, 3600)
+    },
+    release: function (ino, fd, cb) {
+      cb(0)
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+
+    fs.open(path.join(mnt, 'test'), 'wx', function (err, fd) {
+      t.error(err, 'no error')
+      fs.fstat(fd, function (err, st) {
+        t.error(err, 'no error')
+        t.same(st.ino, 2, 'stat of the new file')
+        t.same(getattrs, 0, 'attributes came from the create reply')
+        fs.close(fd, function () {
+          fuse.unmount(mnt, function () {
+            t.end()
+          })
+        })
+      })
+    })
+  })
+})
+
+tape('lowlevel (rename and setattr)', function (t) {
+  var root = stat({mode: 'dir', size: 4096})
+  var file = stat({mode: 'file', size: 11})
+  var name = 'test'
+  root.ino = 1
+  file.ino = 2
+
+  var ops = {
+    force: true,
+    lowlevel: true,
+    lookup: function (parent, n, cb) {
+      if (parent === 1 && n === name) return cb(0, file)
+      return cb(fuse.ENOENT)
+    },
+    getattr: function (ino, cb) {
+      if (ino === 1) return cb(0, root)
+      if (ino === 2) return cb(0, file)
+      return cb(fuse.ENOENT)
+    },
+    rename: function (parent, n, newparent, newname, cb) {
+      t.same([parent, n, newparent, newname], [1, 'test', 1, 'renamed'], 'rename arguments')
+      name = newname
+      cb(0)
+    },
+    chmod: function (ino, mode, cb) {
+      t.same(ino, 2, 'chmod the right inode')
+      file.mode = (file.mode & ~0o777) | (mode & 0o777)
+      cb(0)
+    },
+    truncate: function (ino, size, cb) {
+      t.same(ino, 2, 'truncate the right inode')
+      file.size = size
+      cb(0)
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+
+    fs.rename(path.join(mnt, 'test'), path.join(mnt, 'renamed'), function (err) {
+      t.error(err, 'no error')
+
+      fs.chmod(path.join(mnt, 'renamed'), 0o600, function (err) {
+        t.error(err, 'no error')
+
+        fs.truncate(path.join(mnt, 'renamed'), 5, function (err) {
+          t.error(err, 'no error')
+
+          fs.stat(path.join(mnt, 'renamed'), function (err, st) {
+            t.error(err, 'no error')
+            t.same(st.mode & 0o777, 0o600, 'mode changed')
+            t.same(st.size, 5, 'size changed')
+
+            fuse.unmount(mnt, function () {
+              t.end()
+            })
+          })
+        })
+      })
+    })
+  })
+})
+
+tape('lowlevel (mkdir in a removed directory)', function (t) {
+  var root = stat({mode: 'dir', size: 4096})
+  var dir = stat({mode: 'dir', size: 4096})
+  root.ino = 1
+  dir.ino = 2
+
+  var ops = {
+    force: true,
+    lowlevel: true,
+    negativeTimeout: 10,
+    lookup: function (parent, name, cb) {
+      if (parent === 1 && name === 'dir') return cb(0, dir)
+      return cb(fuse.ENOENT)
+    },
+    getattr: function (ino, cb) {
+      if (ino === 1) return cb(0, root)
+      if (ino === 2) return cb(0, dir)
+      return cb(fuse.ENOENT)
+    },
+    mkdir: function (parent, name, mode, cb) {
+      t.same(parent, 2, 'mkdir in the right directory')
+      cb(fuse.ENOENT) // removed behind the kernel's back
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+
+    fs.mkdir(path.join(mnt, 'dir', 'sub'), function (err) {
+      t.same(err && err.code, 'ENOENT', 'missing parent is reported as ENOENT')
+
+      fuse.unmount(mnt, function () {
+        t.end()
+      })
+    })
+  })
+})
+
+tape('lowlevel (xattr cache is refused)', function (t) {
+  fuse.mount(mnt, {force: true, lowlevel: true, xattrCache: true}, function (err) {
+    t.ok(err, 'had error')
+    t.end()
+  })
+})
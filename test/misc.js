@@ -1,6 +1,14 @@
 var mnt = require('./fixtures/mnt')
+var stat = require('./fixtures/stat')
+var mount = require('./fixtures/mount')
 var fuse = require('../')
 var tape = require('tape')
+var fs = require('fs')
+var path = require('path')
+var execFile = require('child_process').execFile
+var spawnSync = require('child_process').spawnSync
+
+var python = !spawnSync('python3', ['--version']).error // the xattr test reads attributes through it
 
 tape('mount', function (t) {
   fuse.mount(mnt, {force: true}, function (err) {
@@ -41,3 +49,540 @@ tape('mnt point must be directory', function (t) {
     t.end()
   })
 })
+
+tape('attr cache', function (t) {
+  var calls = 0
+  var ops = {
+    attrTimeout: 0,
+    attrCache: true,
+    getattr: function (path, cb) {
+      if (path !== '/test') return cb(fuse.ENOENT)
+      calls++
+      cb(0, stat({mode: 'file', size: 42}), 60)
+    }
+  }
+
+  mount(t, ops, function (done) {
+    fs.stat(path.join(mnt, 'test'), function (err, st) {
+      t.error(err, 'no error')
+      t.same(st.size, 42, 'stat is right')
+      fs.stat(path.join(mnt, 'test'), function (err, st) {
+        t.error(err, 'no error')
+        t.same(st.size, 42, 'cached stat is right')
+        t.same(calls, 1, 'served from the cache')
+        t.ok(fuse.attrCacheStats(mnt).hits > 0, 'counted hits')
+
+        fuse.invalidateAttr(mnt, '/test')
+        fs.stat(path.join(mnt, 'test'), function (err) {
+          t.error(err, 'no error')
+          t.same(calls, 2, 'invalidated')
+          done()
+        })
+      })
+    })
+  })
+})
+
+tape('invalidate by path', function (t) {
+  var calls = 0
+  var ops = {
+    attrTimeout: 0,
+    attrCache: true,
+    getattr: function (path, cb) {
+      if (path !== '/dir/test') return cb(0, stat({mode: 'dir', size: 4096}), 60)
+      calls++
+      cb(0, stat({mode: 'file', size: 42}), 60)
+    }
+  }
+
+  mount(t, ops, function (done) {
+    fs.stat(path.join(mnt, 'dir/test'), function (err) {
+      t.error(err, 'no error')
+      fuse.invalidate(mnt, '/dir/test', function (err) {
+        t.error(err, 'no error')
+        fs.stat(path.join(mnt, 'dir/test'), function (err) {
+          t.error(err, 'no error')
+          t.same(calls, 2, 'invalidated the path')
+          fuse.invalidateEntry(mnt, '/dir', 'test', function (err) {
+            t.error(err, 'no error')
+            fs.stat(path.join(mnt, 'dir/test'), function (err) {
+              t.error(err, 'no error')
+              t.same(calls, 3, 'invalidated the entry')
+              done()
+            })
+          })
+        })
+      })
+    })
+  })
+})
+
+tape('readdir with offsets', function (t) {
+  var names = []
+  for (var i = 0; i < 5000; i++) names.push('file-' + i)
+  var calls = 0
+
+  var ops = {
+    force: true,
+    readdir: function (path, offset, cb) {
+      calls++
+      cb(0, names.slice(offset, offset + 100), names.slice(offset, offset + 100).map(function () {
+        return stat({mode: 'file', size: 0})
+      }))
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+    fs.readdir(mnt, function (err, list) {
+      t.error(err, 'no error')
+      t.same(list.length, names.length, 'listed all entries')
+      t.ok(calls > 1, 'listed in pages')
+      fuse.unmount(mnt, function () {
+        t.end()
+      })
+    })
+  })
+})
+
+tape('stats', function (t) {
+  var ops = {
+    pathCache: true,
+    attrTimeout: 0,
+    getattr: function (path, cb) {
+      setTimeout(function () {
+        cb(0, stat({mode: 'file', size: 42}))
+      }, 10)
+    }
+  }
+
+  mount(t, ops, function (done) {
+    fs.stat(path.join(mnt, 'test'), function (err) {
+      t.error(err, 'no error')
+
+      var stats = fuse.stats(mnt)
+      t.same(stats.inflight, 0, 'nothing in flight')
+      t.ok(stats.ops.getattr.total.count > 0, 'counted getattr')
+      t.ok(stats.ops.getattr.handler.max >= 5000, 'handler time was recorded')
+      t.ok(stats.pathCache.misses > 0, 'paths went through the path cache')
+
+      fuse.resetStats(mnt)
+      t.notOk(fuse.stats(mnt).ops.getattr, 'reset histograms')
+      done()
+    })
+  })
+})
+
+tape('packed stat', function (t) {
+  var st = fuse.packStat(stat({mode: 'file', size: 4242}))
+  st[fuse.STAT_FIELDS.indexOf('mtimeSec')] = 1000
+  st[fuse.STAT_FIELDS.indexOf('mtimeNsec')] = 123456789
+  st[fuse.STAT_FIELDS.indexOf('atimeSec')] = NaN
+  t.same(st.length, fuse.STAT_FIELDS.length, 'one slot per field')
+
+  var ops = {
+    force: true,
+    getattr: function (path, cb) {
+      if (path === '/') return cb(0, stat({mode: 'dir', size: 4096}))
+      cb(0, st)
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+    fs.stat(path.join(mnt, 'test'), function (err, st) {
+      t.error(err, 'no error')
+      t.same(st.size, 4242, 'size was decoded')
+      t.ok(st.isFile(), 'mode was decoded')
+      t.same(st.mtime.getTime(), 1000123, 'mtime was decoded')
+      t.same(st.atime.getTime(), 0, 'NaN became 0')
+      fuse.unmount(mnt, function () {
+        t.end()
+      })
+    })
+  })
+})
+
+tape('workers', function (t) {
+  var ops = {
+    force: true,
+    workers: {module: path.join(__dirname, 'fixtures/worker-ops.js'), count: 2}
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+    fs.readdir(mnt, function (err, list) {
+      t.error(err, 'no error')
+      t.same(list, ['thread'], 'readdir ran in a worker')
+      fs.readFile(path.join(mnt, 'thread'), 'utf-8', function (err, id) {
+        t.error(err, 'no error')
+        t.ok(Number(id) > 0, 'read ran in a worker')
+        t.same(fuse.stats(mnt).inflight, 0, 'nothing in flight')
+        fuse.unmount(mnt, function () {
+          t.end()
+        })
+      })
+    })
+  })
+})
+
+tape('workers (failing module)', function (t) {
+  var ops = {
+    force: true,
+    workers: {module: path.join(__dirname, 'fixtures/worker-throws.js'), count: 2}
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.ok(err, 'mount failed')
+    t.same(err && err.message, 'broken worker module', 'with the error of the worker')
+    t.end()
+  })
+})
+
+tape('shared driver', {skip: process.platform !== 'linux'}, function (t) {
+  var mnts = [0, 1, 2].map(function (i) {
+    var dir = mnt + '-shared-' + i
+    try {
+      fs.mkdirSync(dir)
+    } catch (err) {
+      // do nothing
+    }
+    return dir
+  })
+
+  var ops = {
+    force: true,
+    sharedDriver: 2,
+    getattr: function (path, cb) {
+      if (path === '/') return cb(0, stat({mode: 'dir', size: 4096}))
+      if (path === '/test') return cb(0, stat({mode: 'file', size: 42}))
+      cb(fuse.ENOENT)
+    }
+  }
+
+  var missing = mnts.length
+  mnts.forEach(function (dir) {
+    fuse.mount(dir, ops, function (err) {
+      t.error(err, 'no error')
+      if (--missing) return
+
+      // more mounts than driver threads, all served at the same time
+      var stats = 0
+      mnts.forEach(function (dir) {
+        fs.stat(path.join(dir, 'test'), function (err, st) {
+          t.error(err, 'no error')
+          t.same(st.size, 42, 'served by the shared driver')
+          if (++stats < mnts.length) return
+
+          var unmounted = 0
+          mnts.forEach(function (dir) {
+            fuse.unmount(dir, function () {
+              fs.rmdirSync(dir)
+              if (++unmounted === mnts.length) t.end()
+            })
+          })
+        })
+      })
+    })
+  })
+})
+
+tape('shared driver (blocked mounts)', {skip: process.platform !== 'linux'}, function (t) {
+  var mnts = [0, 1, 2, 3].map(function (i) {
+    var dir = mnt + '-blocked-' + i
+    try {
+      fs.mkdirSync(dir)
+    } catch (err) {
+      // do nothing
+    }
+    return dir
+  })
+
+  var blocked = []
+  var ops = function (slow) {
+    return {
+      force: true,
+      sharedDriver: 1,
+      getattr: function (path, cb) {
+        if (path === '/') return cb(0, stat({mode: 'dir', size: 4096}))
+        if (path !== '/test') return cb(fuse.ENOENT)
+        if (!slow) return cb(0, stat({mode: 'file', size: 42}))
+        blocked.push(cb)
+        if (blocked.length === 2) serve()
+      }
+    }
+  }
+
+  var unmount = function () {
+    var unmounted = 0
+    mnts.forEach(function (dir) {
+      fuse.unmount(dir, function () {
+        fs.rmdirSync(dir)
+        if (++unmounted === mnts.length) t.end()
+      })
+    })
+  }
+
+  // both slow handlers hold a driver thread, the other mounts are still served
+  var serve = function () {
+    fs.stat(path.join(mnts[2], 'test'), function (err, st) {
+      t.error(err, 'no error')
+      t.same(st.size, 42, 'served next to the blocked mounts')
+
+      fuse.mount(mnts[3], ops(false), function (err) {
+        t.error(err, 'mounted next to the blocked mounts')
+        fs.stat(path.join(mnts[3], 'test'), function (err, st) {
+          t.error(err, 'no error')
+          t.same(st.size, 42, 'served by the new mount')
+          blocked.forEach(function (cb) {
+            cb(0, stat({mode: 'file', size: 42}))
+          })
+        })
+      })
+    })
+  }
+
+  var missing = 2
+  var done = function (err, st) {
+    t.error(err, 'no error')
+    t.same(st.size, 42, 'blocked mount answered')
+    if (!--missing) unmount()
+  }
+
+  var mounted = 0
+  mnts.slice(0, 3).forEach(function (dir, i) {
+    fuse.mount(dir, ops(i < 2), function (err) {
+      t.error(err, 'no error')
+      if (++mounted < 3) return
+      fs.stat(path.join(mnts[0], 'test'), done)
+      fs.stat(path.join(mnts[1], 'test'), done)
+    })
+  })
+})
+
+tape('unmountMany', function (t) {
+  var mnts = [0, 1].map(function (i) {
+    var dir = mnt + '-many-' + i
+    try {
+      fs.mkdirSync(dir)
+    } catch (err) {
+      // do nothing
+    }
+    return dir
+  })
+
+  fuse.mount(mnts[0], {force: true}, function (err) {
+    t.error(err, 'no error')
+    fuse.mount(mnts[1], {force: true}, function (err) {
+      t.error(err, 'no error')
+      t.same(fuse.mounted().sort(), mnts.slice().sort(), 'both mounted')
+      fuse.unmountMany(mnts.concat(mnt + '.not-mounted'), function (err, results) {
+        t.ok(err, 'had error')
+        t.same(results.map(function (r) { return r.mnt }), mnts.concat(mnt + '.not-mounted'), 'results in order')
+        t.same(results[0].error, null, 'unmounted')
+        t.same(results[1].error, null, 'unmounted')
+        t.ok(results[2].error, 'was not mounted')
+        t.same(fuse.mounted(), [], 'nothing mounted')
+        mnts.forEach(function (dir) {
+          fs.rmdirSync(dir)
+        })
+        t.end()
+      })
+    })
+  })
+})
+
+tape('xattr policy + cache', {skip: process.platform !== 'linux' || !python}, function (t) {
+  var calls = 0
+  var ops = {
+    xattrPolicy: {'user.static': 'hello', 'user.none': fuse.ENODATA, 'user.js*': true},
+    xattrCache: {ttl: 60},
+    getattr: function (path, cb) {
+      if (path === '/test') return cb(0, stat({mode: 'file', size: 0}))
+      cb(fuse.ENOENT)
+    },
+    getxattr: function (path, name, buffer, length, offset, cb) {
+      calls++
+      if (name !== 'user.js') return cb(fuse.ENODATA)
+      if (length) buffer.write('js')
+      cb(2)
+    }
+  }
+
+  // node has no xattr api
+  var script = [
+    'import os, sys',
+    'for n in sys.argv[2:]:',
+    '  try: print(os.getxattr(sys.argv[1], n).decode())',
+    '  except OSError as e: print(e.errno)'
+  ].join('\n')
+  var names = ['user.static', 'user.none', 'user.js', 'user.js', 'user.other', 'user.other']
+
+  mount(t, ops, function (done) {
+    execFile('python3', ['-c', script, path.join(mnt, 'test')].concat(names), function (err, stdout) {
+      t.error(err, 'no error')
+      t.same(stdout.trim().split('\n'), ['hello', '61', 'js', 'js', '61', '61'], 'xattr values')
+      t.same(calls, 2, 'only uncached names reached the handler')
+      done()
+    })
+  })
+})
+
+tape('negative rules + cache', function (t) {
+  var calls = 0
+  var ops = {
+    negativeRules: ['._*', {prefix: '/.Spotlight-V100'}, {prefix: '/tmp'}],
+    negativeCache: {ttl: 60},
+    getattr: function (path, cb) {
+      calls++
+      cb(fuse.ENOENT)
+    }
+  }
+
+  var missing = function (name, expected, cb) {
+    fs.stat(path.join(mnt, name), function (err) {
+      t.same(err && err.code, 'ENOENT', name + ' does not exist')
+      t.same(calls, expected, expected + ' calls into js')
+      cb()
+    })
+  }
+
+  mount(t, ops, function (done) {
+    missing('._test', 0, function () {
+      missing('.Spotlight-V100/store', 0, function () {
+        missing('tmp', 0, function () {
+          missing('tmpfoo', 1, function () { // prefixes match whole components only
+            missing('missing', 2, function () {
+              missing('missing', 2, function () {
+                fuse.addNegativeRule(mnt, '*.tmp')
+                missing('a.tmp', 2, function () {
+                  t.ok(fuse.removeNegativeRule(mnt, '*.tmp'), 'rule removed')
+                  missing('a.tmp', 3, function () {
+                    fuse.invalidateNegative(mnt, '/a.tmp')
+                    missing('a.tmp', 4, done)
+                  })
+                })
+              })
+            })
+          })
+        })
+      })
+    })
+  })
+})
+
+tape('async release', function (t) {
+  var pending = []
+  var ops = {
+    asyncRelease: {maxQueue: 16},
+    getattr: function (path, cb) {
+      if (path === '/test') return cb(0, stat({mode: 'file', size: 0}))
+      cb(fuse.ENOENT)
+    },
+    open: function (path, flags, cb) {
+      cb(0, 42)
+    },
+    release: function (path, fd, cb) {
+      t.same(path, '/test', 'release path')
+      t.same(fd, 42, 'release fd')
+      pending.push(cb) // close must not wait for this
+    }
+  }
+
+  mount(t, ops, function (done) {
+    fs.open(path.join(mnt, 'test'), 'r', function (err, fd) {
+      t.error(err, 'no error')
+      fs.close(fd, function (err) {
+        t.error(err, 'closed before release called back')
+        setTimeout(function () {
+          t.same(pending.length, 1, 'release was called')
+          t.same(fuse.stats(mnt).asyncRelease.deferred, 1, 'release was deferred')
+          pending.shift()(0)
+          done()
+        }, 100)
+      })
+    })
+  })
+})
+
+tape('async release (burst)', function (t) {
+  var releases = 0
+  var ops = {
+    asyncRelease: {maxQueue: 1024},
+    getattr: function (path, cb) {
+      if (path === '/test') return cb(0, stat({mode: 'file', size: 0}))
+      cb(fuse.ENOENT)
+    },
+    open: function (path, flags, cb) {
+      cb(0, 42)
+    },
+    release: function (path, fd, cb) {
+      releases++
+      setTimeout(cb, 50, 0)
+    }
+  }
+
+  mount(t, ops, function (done) {
+    var fds = []
+    var count = 300
+
+    for (var i = 0; i < count; i++) {
+      fs.open(path.join(mnt, 'test'), 'r', function (err, fd) {
+        if (err) t.error(err, 'no error')
+        fds.push(fd)
+        if (fds.length === count) close()
+      })
+    }
+
+    // more releases at once than the request queue has slots
+    var close = function () {
+      var closed = 0
+      fds.forEach(function (fd) {
+        fs.close(fd, function (err) {
+          if (err) t.error(err, 'no error')
+          if (++closed < count) return
+          setTimeout(function () {
+            var stats = fuse.stats(mnt).asyncRelease
+            t.same(stats.maxQueue, 128, 'queue is capped below the ring size')
+            t.same(stats.deferred + stats.overflows, count, 'every release was counted')
+            t.same(releases, count, 'every release was called')
+            done()
+          }, 200)
+        })
+      })
+    }
+  })
+})
+
+tape('null path', {skip: process.platform === 'win32'}, function (t) {
+  var ops = {
+    nullPath: true,
+    getattr: function (path, cb) {
+      if (path === '/test') return cb(0, stat({mode: 'file', size: 5}))
+      cb(fuse.ENOENT)
+    },
+    open: function (path, flags, cb) {
+      t.same(path, '/test', 'open gets a path')
+      cb(0, 42)
+    },
+    read: function (path, fd, buf, len, pos, cb) {
+      t.same(path, undefined, 'read gets no path')
+      t.same(fd, 42, 'read gets the fd')
+      var data = Buffer.from('hello').slice(pos, pos + len)
+      data.copy(buf)
+      cb(data.length)
+    },
+    release: function (path, fd, cb) {
+      t.same(path, undefined, 'release gets no path')
+      cb(0)
+    }
+  }
+
+  mount(t, ops, function (done) {
+    fs.readFile(path.join(mnt, 'test'), function (err, buf) {
+      t.error(err, 'no error')
+      t.same(buf.toString(), 'hello', 'read the file')
+      done()
+    })
+  })
+})
@@ -1,5 +1,6 @@
 var mnt = require('./fixtures/mnt')
 var stat = require('./fixtures/stat')
+var mount = require('./fixtures/mount')
 var fuse = require('../')
 var tape = require('tape')
 var fs = require('fs')
@@ -59,3 +60,212 @@ tape('read', function (t) {
     })
   })
 })
+
+tape('read (multithreaded)', function (t) {
+  var files = ['a', 'b', 'c', 'd', 'e', 'f', 'g', 'h']
+  var inflight = 0
+  var maxInflight = 0
+
+  var ops = {
+    force: true,
+    multithreaded: true,
+    readdir: function (path, cb) {
+      if (path === '/') return cb(null, files)
+      return cb(fuse.ENOENT)
+    },
+    getattr: function (path, cb) {
+      if (path === '/') return cb(null, stat({mode: 'dir', size: 4096}))
+      if (files.indexOf(path.slice(1)) > -1) return cb(null, stat({mode: 'file', size: 11}))
+      return cb(fuse.ENOENT)
+    },
+    open: function (path, flags, cb) {
+      cb(0, 42)
+    },
+    read: function (path, fd, buf, len, pos, cb) {
+      var str = 'hello world'.slice(pos, pos + len)
+      if (!str) return cb(0)
+      inflight++
+      maxInflight = Math.max(maxInflight, inflight)
+      setTimeout(function () {
+        inflight--
+        buf.write(str)
+        cb(str.length)
+      }, 50)
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+
+    var missing = files.length
+    files.forEach(function (name) {
+      fs.readFile(path.join(mnt, name), function (err, buf) {
+        t.error(err, 'no error')
+        t.same(buf, new Buffer('hello world'), 'read ' + name)
+        if (--missing) return
+        t.ok(maxInflight > 1, 'reads were served concurrently')
+        fuse.unmount(mnt, function () {
+          t.end()
+        })
+      })
+    })
+  })
+})
+
+tape('read (zero copy)', function (t) {
+  var backing = fs.openSync(__filename, 'r')
+  var size = fs.fstatSync(backing).size
+
+  var ops = {
+    force: true,
+    zeroCopy: true,
+    readdir: function (path, cb) {
+      if (path === '/') return cb(null, ['test'])
+      return cb(fuse.ENOENT)
+    },
+    getattr: function (path, cb) {
+      if (path === '/') return cb(null, stat({mode: 'dir', size: 4096}))
+      if (path === '/test') return cb(null, stat({mode: 'file', size: size}))
+      return cb(fuse.ENOENT)
+    },
+    open: function (path, flags, cb) {
+      cb(0, 42)
+    },
+    read: function (path, fd, buf, len, pos, cb) {
+      cb(Math.max(0, Math.min(len, size - pos)), backing, pos)
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+
+    fs.readFile(path.join(mnt, 'test'), function (err, buf) {
+      t.error(err, 'no error')
+      t.same(buf, fs.readFileSync(__filename), 'read file from fd')
+
+      fuse.unmount(mnt, function () {
+        fs.closeSync(backing)
+        t.end()
+      })
+    })
+  })
+})
+
+tape('read (object file handles)', function (t) {
+  var handle = {name: 'test'}
+
+  var ops = {
+    force: true,
+    readdir: function (path, cb) {
+      if (path === '/') return cb(null, ['test'])
+      return cb(fuse.ENOENT)
+    },
+    getattr: function (path, cb) {
+      if (path === '/') return cb(null, stat({mode: 'dir', size: 4096}))
+      if (path === '/test') return cb(null, stat({mode: 'file', size: 11}))
+      return cb(fuse.ENOENT)
+    },
+    open: function (path, flags, cb) {
+      cb(0, handle)
+    },
+    release: function (path, fd, cb) {
+      t.ok(fd === handle, 'handle was passed to release')
+      cb(0)
+    },
+    read: function (path, fd, buf, len, pos, cb) {
+      t.ok(fd === handle, 'handle was passed to read')
+      var str = 'hello world'.slice(pos, pos + len)
+      if (!str) return cb(0)
+      buf.write(str)
+      return cb(str.length)
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+
+    fs.readFile(path.join(mnt, 'test'), function (err, buf) {
+      t.error(err, 'no error')
+      t.same(buf, new Buffer('hello world'), 'read file')
+
+      fuse.unmount(mnt, function () {
+        t.end()
+      })
+    })
+  })
+})
+
+tape('read (read cache)', function (t) {
+  var data = Buffer.alloc(2 * 1024 * 1024)
+  for (var i = 0; i < data.length; i++) data[i] = i % 251
+
+  var ops = {
+    readCache: {blockSize: 64 * 1024, readahead: 512 * 1024},
+    getattr: function (path, cb) {
+      if (path === '/test') return cb(null, stat({mode: 'file', size: data.length}))
+      return cb(fuse.ENOENT)
+    },
+    open: function (path, flags, cb) {
+      cb(0, 42)
+    },
+    read: function (path, fd, buf, len, pos, cb) {
+      setTimeout(function () {
+        cb(data.copy(buf, 0, pos, Math.min(data.length, pos + len)))
+      }, 1)
+    }
+  }
+
+  mount(t, ops, function (done) {
+    fs.readFile(path.join(mnt, 'test'), function (err, buf) {
+      t.error(err, 'no error')
+      t.ok(buf.equals(data), 'read the whole file')
+
+      var stats = fuse.stats(mnt).readCache
+      t.ok(stats.prefetches > 0, 'blocks were prefetched')
+      t.ok(stats.hits > 0, 'reads were served from the cache')
+      done()
+    })
+  })
+})
+
+tape('read (direct io)', function (t) {
+  var reads = 0
+
+  var ops = {
+    force: true,
+    getattr: function (path, cb) {
+      if (path === '/') return cb(null, stat({mode: 'dir', size: 4096}))
+      if (path === '/test') return cb(null, stat({mode: 'file', size: 11}))
+      return cb(fuse.ENOENT)
+    },
+    open: function (path, flags, cb) {
+      cb(0, 42, {directIo: true})
+    },
+    read: function (path, fd, buf, len, pos, cb) {
+      reads++
+      var str = 'hello world'.slice(pos, pos + len)
+      if (!str) return cb(0)
+      buf.write(str)
+      return cb(str.length)
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+
+    fs.readFile(path.join(mnt, 'test'), function (err, buf) {
+      t.error(err, 'no error')
+      var before = reads
+
+      fs.readFile(path.join(mnt, 'test'), function (err, buf) {
+        t.error(err, 'no error')
+        t.same(buf, new Buffer('hello world'), 'read file')
+        t.ok(reads > before, 'second read bypassed the page cache')
+
+        fuse.unmount(mnt, function () {
+          t.end()
+        })
+      })
+    })
+  })
+})
@@ -1,5 +1,6 @@
 var mnt = require('./fixtures/mnt')
 var stat = require('./fixtures/stat')
+var mount = require('./fixtures/mount')
 var fuse = require('../')
 var tape = require('tape')
 var fs = require('fs')
@@ -52,3 +53,138 @@ tape('write', function (t) {
     })
   })
 })
+
+tape('write (big writes)', function (t) {
+  var data = Buffer.alloc(64 * 1024, 'a')
+  var largest = 0
+  var size = 0
+
+  var ops = {
+    force: true,
+    bigWrites: true,
+    init: function (mnt, conn, cb) {
+      if (conn.capable.bigWrites) t.ok(conn.want.bigWrites, 'big writes negotiated')
+      t.ok(conn.maxWrite > 4096, 'max write is reported')
+      cb(0)
+    },
+    getattr: function (path, cb) {
+      if (path === '/') return cb(null, stat({mode: 'dir', size: 4096}))
+      if (path === '/hello') return cb(null, stat({mode: 'file', size: size}))
+      return cb(fuse.ENOENT)
+    },
+    truncate: function (path, size, cb) {
+      cb(0)
+    },
+    open: function (path, flags, cb) {
+      cb(0, 42)
+    },
+    write: function (path, fd, buf, len, pos, cb) {
+      largest = Math.max(largest, len)
+      size = Math.max(pos + len, size)
+      cb(len)
+    }
+  }
+
+  fuse.mount(mnt, ops, function (err) {
+    t.error(err, 'no error')
+
+    fs.writeFile(path.join(mnt, 'hello'), data, function (err) {
+      t.error(err, 'no error')
+      t.same(size, data.length, 'all data was written')
+      t.ok(largest > 4096, 'writes were larger than a page')
+
+      fuse.unmount(mnt, function () {
+        t.end()
+      })
+    })
+  })
+})
+
+tape('write (write buffer)', function (t) {
+  var data = Buffer.alloc(64 * 1024)
+  var calls = 0
+  var size = 0
+
+  var ops = {
+    writeBuffer: {maxSize: 16 * 1024},
+    getattr: function (path, cb) {
+      if (path === '/hello') return cb(null, stat({mode: 'file', size: size}))
+      return cb(fuse.ENOENT)
+    },
+    truncate: function (path, size, cb) {
+      cb(0)
+    },
+    open: function (path, flags, cb) {
+      cb(0, 42)
+    },
+    write: function (path, fd, buf, len, pos, cb) {
+      calls++
+      buf.copy(data, pos, 0, len)
+      size = Math.max(pos + len, size)
+      cb(len)
+    }
+  }
+
+  mount(t, ops, function (done) {
+    fs.open(path.join(mnt, 'hello'), 'w', function (err, fd) {
+      t.error(err, 'no error')
+      var missing = 100
+
+      loop()
+
+      function loop () {
+        if (!missing--) return written()
+        fs.write(fd, 'hello world\n', function (err) {
+          if (err) return written(err)
+          loop()
+        })
+      }
+
+      function written (err) {
+        t.error(err, 'no error')
+        t.same(calls, 0, 'writes were buffered')
+        fs.close(fd, function (err) {
+          t.error(err, 'no error')
+          t.ok(calls > 0 && calls < 100, 'writes were coalesced')
+          t.same(data.slice(0, size).toString(), new Array(101).join('hello world\n'), 'data was written')
+          done()
+        })
+      }
+    })
+  })
+})
+
+tape('write (write buffer delay)', function (t) {
+  var written = ''
+
+  var ops = {
+    writeBuffer: {maxDelay: 0.05},
+    getattr: function (path, cb) {
+      if (path === '/hello') return cb(null, stat({mode: 'file', size: written.length}))
+      return cb(fuse.ENOENT)
+    },
+    truncate: function (path, size, cb) {
+      cb(0)
+    },
+    open: function (path, flags, cb) {
+      cb(0, 42)
+    },
+    write: function (path, fd, buf, len, pos, cb) {
+      written += buf.slice(0, len).toString()
+      cb(len)
+    }
+  }
+
+  mount(t, ops, function (done) {
+    fs.open(path.join(mnt, 'hello'), 'w', function (err, fd) {
+      t.error(err, 'no error')
+      fs.write(fd, 'hello world\n', function (err) {
+        t.error(err, 'no error')
+        setTimeout(function () {
+          t.same(written, 'hello world\n', 'idle buffer was written out')
+          fs.close(fd, done)
+        }, 500)
+      })
+    })
+  })
+})
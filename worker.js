@@ -0,0 +1,21 @@
+// serves the ops of a mount from a worker thread, see the workers option in index.js
+var worker = require('worker_threads')
+var fuse = require('./')
+
+var data = worker.workerData
+var ops = require(data.module)
+
+// init, error and destroy always run on the thread that mounted
+var names = Object.keys(ops).filter(function (name) {
+  return typeof ops[name] === 'function' && name !== 'init' && name !== 'error' && name !== 'destroy'
+})
+
+worker.parentPort.once('message', function () {
+  fuse.attach(data.mnt, data.index, ops, data.lowlevel)
+  worker.parentPort.unref() // the bindings keep the thread alive until unmount
+})
+
+worker.parentPort.postMessage({
+  ops: names,
+  readdirOffset: !data.lowlevel && !!ops.readdir && ops.readdir.length > 2
+})